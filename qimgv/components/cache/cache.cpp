@@ -1,6 +1,12 @@
 #include "cache.h"
 
-Cache::Cache() {
+Cache::Cache()
+    : mMaxSize(0),
+      mSize(0),
+      mHits(0),
+      mMisses(0),
+      mEvictions(0)
+{
 }
 
 bool Cache::contains(QString name) {
@@ -12,7 +18,10 @@ bool Cache::insert(std::shared_ptr<Image> img) {
         if(items.contains(img->name())) {
             return false;
         } else {
-            items.insert(img->name(), new CacheItem(img));
+            auto *item = new CacheItem(img);
+            items.insert(img->name(), item);
+            lru.append(img->name());
+            mSize += item->size();
             return true;
         }
     }
@@ -24,24 +33,25 @@ bool Cache::insert(std::shared_ptr<Image> img) {
 void Cache::remove(QString name) {
     if(items.contains(name)) {
         items[name]->lock();
-        auto *item = items.take(name);
-        delete item;
+        destroy(name);
     }
 }
 
 void Cache::clear() {
     for(auto name : items.keys()) {
         items[name]->lock();
-        auto item = items.take(name);
-        delete item;
+        destroy(name);
     }
 }
 
 std::shared_ptr<Image> Cache::get(QString name) {
     if(items.contains(name)) {
+        mHits++;
+        touch(name);
         CacheItem *item = items.value(name);
         return item->getContents();
     }
+    mMisses++;
     return nullptr;
 }
 
@@ -68,12 +78,69 @@ void Cache::trimTo(QStringList nameList) {
             //qDebug() << "CACHE-RM: locking.. " << name;
             items[name]->lock();
             //qDebug() << "CACHE-RM: LOCKED: " << name;
-            auto *item = items.take(name);
-            delete item;
+            destroy(name);
         }
     }
 }
 
+// evicts least recently used items until we fit into maxSize
+// pinned items and the ones currently reserved by someone are skipped
+void Cache::trim(QStringList pinned) {
+    if(mMaxSize <= 0)
+        return;
+    // mipmaps are added after insert()
+    for(auto item : items)
+        mSize += item->updateSize();
+    for(int i = 0; i < lru.count() && mSize > mMaxSize;) {
+        QString name = lru.at(i);
+        CacheItem *item = items.value(name);
+        if(pinned.contains(name) || !item->lockStatus()) {
+            i++;
+            continue;
+        }
+        item->lock();
+        destroy(name);
+        mEvictions++;
+    }
+}
+
 const QList<QString> Cache::keys() {
     return items.keys();
 }
+
+void Cache::setMaxSize(qint64 bytes) {
+    mMaxSize = bytes;
+}
+
+qint64 Cache::maxSize() const {
+    return mMaxSize;
+}
+
+qint64 Cache::size() const {
+    return mSize;
+}
+
+quint64 Cache::hits() const {
+    return mHits;
+}
+
+quint64 Cache::misses() const {
+    return mMisses;
+}
+
+quint64 Cache::evictions() const {
+    return mEvictions;
+}
+
+void Cache::touch(QString name) {
+    lru.removeOne(name);
+    lru.append(name);
+}
+
+// item must be locked by the caller
+void Cache::destroy(QString name) {
+    auto *item = items.take(name);
+    lru.removeOne(name);
+    mSize -= item->size();
+    delete item;
+}
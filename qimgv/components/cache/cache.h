@@ -8,6 +8,9 @@
 #include "components/cache/cacheitem.h"
 #include "utils/imagefactory.h"
 
+// Decoded image cache with a memory budget.
+// Items are kept until the total size goes over maxSize(),
+// then the least recently used ones get evicted by trim().
 class Cache {
 public:
     explicit Cache();
@@ -17,12 +20,28 @@ public:
 
     bool insert(std::shared_ptr<Image> img);
     void trimTo(QStringList list);
+    void trim(QStringList pinned);
 
     std::shared_ptr<Image> get(QString name);
     bool release(QString name);
     bool reserve(QString name);
     const QList<QString> keys();
 
+    void setMaxSize(qint64 bytes);
+    qint64 maxSize() const;
+    qint64 size() const;
+
+    quint64 hits() const;
+    quint64 misses() const;
+    quint64 evictions() const;
+
 private:
     QMap<QString, CacheItem*> items;
+    // least recently used first
+    QList<QString> lru;
+    qint64 mMaxSize, mSize;
+    quint64 mHits, mMisses, mEvictions;
+
+    void touch(QString name);
+    void destroy(QString name);
 };
@@ -1,12 +1,14 @@
 #include "cacheitem.h"
+#include "sourcecontainers/imagestatic.h"
 
-CacheItem::CacheItem() {
+CacheItem::CacheItem() : mSize(0) {
     sem = new QSemaphore(1);
 }
 
 CacheItem::CacheItem(std::shared_ptr<Image> _contents) {
     contents = _contents;
     sem = new QSemaphore(1);
+    mSize = estimateSize();
 }
 
 CacheItem::~CacheItem() {
@@ -28,3 +30,33 @@ void CacheItem::unlock() {
 int CacheItem::lockStatus() {
     return sem->available();
 }
+
+qint64 CacheItem::size() const {
+    return mSize;
+}
+
+qint64 CacheItem::updateSize() {
+    qint64 oldSize = mSize;
+    mSize = estimateSize();
+    return mSize - oldSize;
+}
+
+qint64 CacheItem::estimateSize() {
+    if(!contents)
+        return 0;
+    if(contents->type() == STATIC) {
+        auto img = contents->getImage();
+        qint64 bytes = img ? static_cast<qint64>(img->bytesPerLine()) * img->height() : 0;
+        // the scaler builds these later
+        auto imgStatic = dynamic_cast<ImageStatic*>(contents.get());
+        if(imgStatic)
+            bytes += imgStatic->mipmapSize();
+        return bytes;
+    }
+    // video is decoded by mpv elsewhere
+    if(contents->type() == VIDEO)
+        return 0;
+    // gifs etc: count at least one decoded frame
+    QSize sz = contents->size();
+    return static_cast<qint64>(sz.width()) * sz.height() * 4;
+}
@@ -15,8 +15,13 @@ public:
     void unlock();
 
     int lockStatus();
+    // approximate memory usage in bytes
+    qint64 size() const;
+    // re-estimates, the image may have grown mipmaps meanwhile; returns the change
+    qint64 updateSize();
 private:
     std::shared_ptr<Image> contents;
     QSemaphore *sem;
+    qint64 mSize;
+    qint64 estimateSize();
 };
-
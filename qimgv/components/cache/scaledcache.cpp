@@ -0,0 +1,66 @@
+#include "scaledcache.h"
+
+ScaledCache::ScaledCache(qint64 pixelBudget) : mPixels(0), mPixelBudget(pixelBudget) {
+}
+
+int ScaledCache::indexOf(const ScalerRequest &req) const {
+    for(int i = 0; i < entries.count(); i++) {
+        const Entry &e = entries.at(i);
+        if(e.size == req.size && e.filter == req.filter && e.image.lock() == req.image)
+            return i;
+    }
+    return -1;
+}
+
+bool ScaledCache::get(const ScalerRequest &req, QPixmap &pixmap) {
+    if(!req.image)
+        return false;
+    int index = indexOf(req);
+    if(index < 0)
+        return false;
+    entries.move(index, 0);
+    pixmap = entries.first().pixmap;
+    return true;
+}
+
+void ScaledCache::insert(const ScalerRequest &req, const QPixmap &pixmap) {
+    qint64 pixels = static_cast<qint64>(pixmap.width()) * pixmap.height();
+    // a single huge result would just flush everything else
+    if(!req.image || pixmap.isNull() || pixels > mPixelBudget / 2)
+        return;
+    int index = indexOf(req);
+    if(index >= 0) {
+        const QPixmap &old = entries.at(index).pixmap;
+        mPixels -= static_cast<qint64>(old.width()) * old.height();
+        entries.removeAt(index);
+    }
+    entries.prepend({ req.image, req.size, req.filter, req.string, pixmap });
+    mPixels += pixels;
+    trim();
+}
+
+// call when the image behind a path changes (edits, reloads)
+void ScaledCache::remove(QString path) {
+    for(int i = entries.count() - 1; i >= 0; i--) {
+        if(entries.at(i).path == path) {
+            const QPixmap &old = entries.at(i).pixmap;
+            mPixels -= static_cast<qint64>(old.width()) * old.height();
+            entries.removeAt(i);
+        }
+    }
+}
+
+void ScaledCache::clear() {
+    entries.clear();
+    mPixels = 0;
+}
+
+void ScaledCache::trim() {
+    for(int i = entries.count() - 1; i >= 0; i--) {
+        if(mPixels > mPixelBudget || entries.at(i).image.expired()) {
+            const QPixmap &old = entries.at(i).pixmap;
+            mPixels -= static_cast<qint64>(old.width()) * old.height();
+            entries.removeAt(i);
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QPixmap>
+#include <QList>
+#include <memory>
+#include "components/scaler/scalerrequest.h"
+
+// Recently produced scaling results, keyed by image, size and filter.
+// Bounded by the total pixel count; least recently used entries go first.
+// Entries don't keep their image alive and are dropped once it is gone.
+class ScaledCache {
+public:
+    explicit ScaledCache(qint64 pixelBudget = DEFAULT_PIXEL_BUDGET);
+    bool get(const ScalerRequest &req, QPixmap &pixmap);
+    void insert(const ScalerRequest &req, const QPixmap &pixmap);
+    void remove(QString path);
+    void clear();
+
+    static const qint64 DEFAULT_PIXEL_BUDGET = 3840 * 2160 * 3;
+
+private:
+    struct Entry {
+        std::weak_ptr<Image> image;
+        QSize size;
+        ScalingFilter filter;
+        QString path;
+        QPixmap pixmap;
+    };
+    // most recently used first
+    QList<Entry> entries;
+    qint64 mPixels, mPixelBudget;
+
+    int indexOf(const ScalerRequest &req) const;
+    void trim();
+};
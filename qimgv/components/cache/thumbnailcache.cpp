@@ -1,38 +1,365 @@
 #include "thumbnailcache.h"
 
-ThumbnailCache::ThumbnailCache() {
+#include <QSaveFile>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+const quint32 RECORD_MAGIC = 0x42485451; // "QTHB"
+const char *STORE_FILE_NAME = "thumbnails.pack";
+// don't bother compacting small stores
+const qint64 COMPACT_MIN_SIZE = 32 * 1024 * 1024;
+
+struct RecordHeader {
+    quint32 magic;
+    quint32 headerChecksum; // over the fields below
+    quint32 keyLength;
+    quint32 textLength;
+    quint32 width;
+    quint32 height;
+    quint32 format;
+    quint32 dataLength;     // pixel rows, tightly packed
+    quint32 dataChecksum;   // over key, text and pixels
+    quint32 reserved;
+};
+
+// fnv-1a
+quint32 checksum(const uchar *data, qint64 length, quint32 hash = 2166136261u) {
+    for(qint64 i = 0; i < length; i++) {
+        hash ^= data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+quint32 headerChecksum(const RecordHeader &h) {
+    return checksum(reinterpret_cast<const uchar *>(&h.keyLength),
+                    sizeof(RecordHeader) - offsetof(RecordHeader, keyLength));
+}
+
+// records are padded so that the next header stays aligned
+qint64 recordLength(const RecordHeader &h) {
+    qint64 length = sizeof(RecordHeader) + h.keyLength + h.textLength + h.dataLength;
+    return (length + 7) & ~7LL;
+}
+
+// nullptr if the record is damaged
+QImage *decodeRecord(const uchar *record) {
+    RecordHeader h;
+    memcpy(&h, record, sizeof(RecordHeader));
+    const uchar *payload = record + sizeof(RecordHeader);
+    QImage::Format format = static_cast<QImage::Format>(h.format);
+    bool valid = (format == QImage::Format_ARGB32_Premultiplied || format == QImage::Format_RGB888) &&
+                 h.dataChecksum == checksum(payload, h.keyLength + h.textLength + h.dataLength);
+    if(!valid || h.height == 0)
+        return nullptr;
+    QImage *thumb = new QImage(static_cast<int>(h.width), static_cast<int>(h.height), format);
+    if(thumb->isNull()) {
+        delete thumb;
+        return nullptr;
+    }
+    const int rowLength = static_cast<int>(h.dataLength / h.height);
+    const uchar *data = payload + h.keyLength + h.textLength;
+    for(int y = 0; y < thumb->height(); y++)
+        memcpy(thumb->scanLine(y), data + y * rowLength, rowLength);
+    // key\0value\0 pairs
+    QList<QByteArray> text = QByteArray(reinterpret_cast<const char *>(payload + h.keyLength),
+                                        static_cast<int>(h.textLength)).split('\0');
+    for(int i = 0; i + 1 < text.count(); i += 2)
+        thumb->setText(QString::fromUtf8(text.at(i)), QString::fromUtf8(text.at(i + 1)));
+    return thumb;
+}
+
+}
+
+ThumbnailCache::ThumbnailCache()
+    : queueBytes(0),
+      writerActive(false),
+      stopping(false),
+      map(nullptr),
+      mapSize(0),
+      liveBytes(0)
+{
     cacheDirPath = settings->thumbnailCacheDir();
+    writerPool.setMaxThreadCount(1);
+    open();
+}
+
+ThumbnailCache::~ThumbnailCache() {
+    // write out whatever is queued
+    queueMutex.lock();
+    stopping = true;
+    batchFull.wakeAll();
+    queueMutex.unlock();
+    writerPool.waitForDone();
+    writeQueue();
+    unmap();
+    file.close();
+}
+
+void ThumbnailCache::open() {
+    file.setFileName(cacheDirPath + STORE_FILE_NAME);
+    bool existed = file.exists();
+    if(!file.open(QIODevice::ReadWrite)) {
+        qDebug() << "ThumbnailCache: could not open" << file.fileName();
+        return;
+    }
+    // first run with the packed store; drop the per-file pngs of the old cache
+    if(!existed)
+        removeLegacyThumbnails();
+    scan();
+    compactIfNeeded();
 }
 
-QString ThumbnailCache::thumbnailPath(QString id) {
-    return QString(cacheDirPath + id + ".png");
+// Walk the record headers and rebuild the index.
+// Later records for the same id replace earlier ones.
+void ThumbnailCache::scan() {
+    index.clear();
+    liveBytes = 0;
+    remap();
+    qint64 pos = 0;
+    while(pos + static_cast<qint64>(sizeof(RecordHeader)) <= mapSize) {
+        RecordHeader h;
+        memcpy(&h, map + pos, sizeof(RecordHeader));
+        if(h.magic != RECORD_MAGIC || h.headerChecksum != headerChecksum(h))
+            break;
+        qint64 length = recordLength(h);
+        if(pos + length > mapSize)
+            break;
+        QByteArray key(reinterpret_cast<const char *>(map + pos + sizeof(RecordHeader)), static_cast<int>(h.keyLength));
+        auto old = index.find(key);
+        if(old != index.end())
+            liveBytes -= old->length;
+        index.insert(key, { pos, length });
+        liveBytes += length;
+        pos += length;
+    }
+    // cut off whatever was left half-written by a crash
+    if(pos < file.size()) {
+        qDebug() << "ThumbnailCache: truncating damaged tail at" << pos;
+        unmap();
+        file.resize(pos);
+        remap();
+    }
+}
+
+bool ThumbnailCache::remap() {
+    unmap();
+    qint64 size = file.size();
+    if(size <= 0)
+        return false;
+    map = file.map(0, size);
+    if(!map)
+        return false;
+    mapSize = size;
+    return true;
+}
+
+void ThumbnailCache::unmap() {
+    if(map)
+        file.unmap(map);
+    map = nullptr;
+    mapSize = 0;
 }
 
 bool ThumbnailCache::exists(QString id) {
-    QString filePath = thumbnailPath(id);
-    QFileInfo file(filePath);
-    return file.exists() && file.isReadable();
+    QByteArray key = id.toUtf8();
+    {
+        QMutexLocker locker(&queueMutex);
+        if(queue.contains(key))
+            return true;
+    }
+    QMutexLocker locker(&mutex);
+    return index.contains(key);
 }
 
 void ThumbnailCache::saveThumbnail(QImage *image, QString id) {
-    if(image) {
-        QString filePath = thumbnailPath(id);
-        image->save(filePath, "PNG", 15);
+    if(!image || image->isNull())
+        return;
+    // premultiplied argb if we need alpha, packed rgb otherwise
+    QImage::Format format = image->hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB888;
+    QImage pixels = (image->format() == format) ? *image : image->convertToFormat(format);
+    QByteArray key = id.toUtf8();
+    QByteArray text;
+    for(auto textKey : image->textKeys()) {
+        text.append(textKey.toUtf8()).append('\0');
+        text.append(image->text(textKey).toUtf8()).append('\0');
+    }
+    const int rowLength = pixels.width() * pixels.depth() / 8;
+
+    RecordHeader h;
+    h.magic = RECORD_MAGIC;
+    h.keyLength = static_cast<quint32>(key.size());
+    h.textLength = static_cast<quint32>(text.size());
+    h.width = static_cast<quint32>(pixels.width());
+    h.height = static_cast<quint32>(pixels.height());
+    h.format = static_cast<quint32>(format);
+    h.dataLength = static_cast<quint32>(rowLength * pixels.height());
+    h.reserved = 0;
+    h.headerChecksum = headerChecksum(h);
+    qint64 length = recordLength(h);
+
+    QByteArray record(static_cast<int>(length), '\0');
+    uchar *out = reinterpret_cast<uchar *>(record.data());
+    uchar *payload = out + sizeof(RecordHeader);
+    memcpy(payload, key.constData(), h.keyLength);
+    memcpy(payload + h.keyLength, text.constData(), h.textLength);
+    uchar *data = payload + h.keyLength + h.textLength;
+    for(int y = 0; y < pixels.height(); y++)
+        memcpy(data + y * rowLength, pixels.constScanLine(y), rowLength);
+    h.dataChecksum = checksum(payload, h.keyLength + h.textLength + h.dataLength);
+    memcpy(out, &h, sizeof(RecordHeader));
+
+    QMutexLocker locker(&queueMutex);
+    auto old = queue.find(key);
+    if(old != queue.end())
+        queueBytes -= old->size();
+    queue.insert(key, record);
+    queueBytes += record.size();
+    if(queueBytes >= FLUSH_BATCH_BYTES)
+        batchFull.wakeAll();
+    if(!writerActive) {
+        writerActive = true;
+        QtConcurrent::run(&writerPool, this, &ThumbnailCache::writeQueue);
     }
 }
 
-QImage *ThumbnailCache::readThumbnail(QString id) {
-    QString filePath = thumbnailPath(id);
-    QFileInfo file(filePath);
-    if(file.exists() && file.isReadable()) {
-        QImage *thumb = new QImage();
-        if(thumb->load(filePath)) {
-            return thumb;
-        } else {
-            delete thumb;
-            return nullptr;
+// Writer thread. Lets the queue fill up for a bit, then appends it in one go.
+// Records stay in the queue until they are in the index, so readers always find them.
+void ThumbnailCache::writeQueue() {
+    QMutexLocker locker(&queueMutex);
+    while(!queue.isEmpty()) {
+        if(!stopping && queueBytes < FLUSH_BATCH_BYTES)
+            batchFull.wait(&queueMutex, FLUSH_DELAY_MS);
+        QHash<QByteArray, QByteArray> batch = queue;
+        locker.unlock();
+        writeBatch(batch);
+        locker.relock();
+        for(auto it = batch.constBegin(); it != batch.constEnd(); ++it) {
+            auto queued = queue.find(it.key());
+            // unless it got replaced in the meantime
+            if(queued != queue.end() && queued->constData() == it->constData()) {
+                queueBytes -= queued->size();
+                queue.erase(queued);
+            }
         }
-    } else {
+    }
+    writerActive = false;
+}
+
+void ThumbnailCache::writeBatch(const QHash<QByteArray, QByteArray> &batch) {
+    QByteArray data;
+    for(auto &record : batch)
+        data.append(record);
+    QMutexLocker locker(&mutex);
+    if(!file.isOpen() || data.isEmpty())
+        return;
+    qint64 pos = file.size();
+    if(!file.seek(pos) || file.write(data) != data.size() || !file.flush()) {
+        qDebug() << "ThumbnailCache: write failed for" << batch.count() << "thumbnails";
+        unmap();
+        file.resize(pos);
+        remap();
+        return;
+    }
+    for(auto it = batch.constBegin(); it != batch.constEnd(); ++it) {
+        qint64 length = it->size();
+        auto old = index.find(it.key());
+        if(old != index.end())
+            liveBytes -= old->length;
+        index.insert(it.key(), { pos, length });
+        liveBytes += length;
+        pos += length;
+    }
+    compactIfNeeded();
+}
+
+QImage *ThumbnailCache::readThumbnail(QString id) {
+    QByteArray key = id.toUtf8();
+    QByteArray queued;
+    {
+        QMutexLocker locker(&queueMutex);
+        queued = queue.value(key);
+    }
+    if(!queued.isEmpty())
+        return decodeRecord(reinterpret_cast<const uchar *>(queued.constData()));
+    QMutexLocker locker(&mutex);
+    auto it = index.find(key);
+    if(it == index.end())
         return nullptr;
+    // the file grew since we mapped it
+    if(it->offset + it->length > mapSize && !remap())
+        return nullptr;
+    QImage *thumb = decodeRecord(map + it->offset);
+    if(!thumb) {
+        qDebug() << "ThumbnailCache: damaged record for" << id;
+        liveBytes -= it->length;
+        index.erase(it);
     }
+    return thumb;
+}
+
+void ThumbnailCache::compactIfNeeded() {
+    qint64 maxSize = static_cast<qint64>(settings->thumbnailCacheSize()) * 1024 * 1024;
+    qint64 size = file.size();
+    if(size > maxSize)
+        compact(maxSize * 3 / 4);
+    else if(size > COMPACT_MIN_SIZE && liveBytes < size / 2)
+        compact(maxSize);
+}
+
+// Rewrite live records into a new file, keeping the newest ones that fit into budget.
+// QSaveFile only replaces the store once everything is written, so a crash leaves the old one intact.
+bool ThumbnailCache::compact(qint64 budget) {
+    if(!remap())
+        return false;
+    QList<QPair<QByteArray, Record>> records;
+    records.reserve(index.count());
+    for(auto it = index.constBegin(); it != index.constEnd(); ++it)
+        records.append(qMakePair(it.key(), it.value()));
+    std::sort(records.begin(), records.end(), [](const QPair<QByteArray, Record> &a, const QPair<QByteArray, Record> &b) {
+        return a.second.offset > b.second.offset;
+    });
+    qint64 total = 0;
+    int keep = 0;
+    for(; keep < records.count() && total + records.at(keep).second.length <= budget; keep++)
+        total += records.at(keep).second.length;
+    records.erase(records.begin() + keep, records.end());
+    // keep the original (age) order in the new file
+    std::reverse(records.begin(), records.end());
+
+    QSaveFile out(file.fileName());
+    if(!out.open(QIODevice::WriteOnly))
+        return false;
+    QHash<QByteArray, Record> newIndex;
+    newIndex.reserve(records.count());
+    qint64 pos = 0;
+    for(auto &r : records) {
+        out.write(reinterpret_cast<const char *>(map + r.second.offset), r.second.length);
+        newIndex.insert(r.first, { pos, r.second.length });
+        pos += r.second.length;
+    }
+    unmap();
+    file.close();
+    bool ok = out.commit();
+    if(!file.open(QIODevice::ReadWrite)) {
+        qDebug() << "ThumbnailCache: could not reopen" << file.fileName();
+        index.clear();
+        liveBytes = 0;
+        return false;
+    }
+    if(ok) {
+        index = newIndex;
+        liveBytes = pos;
+    }
+    remap();
+    return ok;
+}
+
+void ThumbnailCache::removeLegacyThumbnails() {
+    QDir dir(cacheDirPath);
+    for(auto &name : dir.entryList(QStringList() << "*.png", QDir::Files))
+        dir.remove(name);
 }
@@ -2,20 +2,32 @@
 
 #include <QObject>
 #include <QDir>
+#include <QFile>
+#include <QHash>
 #include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QtConcurrent>
 #include <QDebug>
 #include "settings.h"
 #include "sourcecontainers/thumbnail.h"
 
+// Packed thumbnail store.
+// Every thumbnail is a record in a single append-only file which is memory-mapped for reading.
+// The id -> record index lives in memory and is rebuilt from record headers on startup.
+// Pixels are stored raw, so reading one is a hash lookup plus a memcpy.
+// Old and superseded records are dropped by compact(), which atomically replaces the file.
+// Writes are asynchronous: records are queued and appended in batches by a writer thread.
+// Queued records are already visible to readers.
 class ThumbnailCache : public QObject
 {
     Q_OBJECT
 public:
     explicit ThumbnailCache();
+    ~ThumbnailCache();
 
     void saveThumbnail(QImage *image, QString id);
     QImage* readThumbnail(QString id);
-    QString thumbnailPath(QString id);
     bool exists(QString id);
 
 signals:
@@ -23,7 +35,38 @@ signals:
 public slots:
 
 private:
-    // we are still bottlenecked by disk access anyway
+    struct Record {
+        qint64 offset;
+        qint64 length;
+    };
+    // guards the file, the map and the index
     QMutex mutex;
+    // guards the write queue
+    QMutex queueMutex;
+    QWaitCondition batchFull;
+    // id -> encoded record, waiting to be written
+    QHash<QByteArray, QByteArray> queue;
+    qint64 queueBytes;
+    bool writerActive, stopping;
+    QThreadPool writerPool;
+    static const int FLUSH_DELAY_MS = 500;
+    static const qint64 FLUSH_BATCH_BYTES = 8 * 1024 * 1024;
+
     QString cacheDirPath;
+    QFile file;
+    uchar *map;
+    qint64 mapSize;
+    QHash<QByteArray, Record> index;
+    // bytes used by records that are still in the index
+    qint64 liveBytes;
+
+    void open();
+    void writeQueue();
+    void writeBatch(const QHash<QByteArray, QByteArray> &batch);
+    void scan();
+    bool remap();
+    void unmap();
+    void compactIfNeeded();
+    bool compact(qint64 budget);
+    void removeLegacyThumbnails();
 };
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QPair>
+
+// A batch of filesystem changes, already applied to the file list.
+// Removals use indices of the old list in descending order, so they can be
+// applied one by one. Insertions come after that and use indices of the new
+// list in ascending order.
+struct DirectoryChanges {
+    QList<int> removedIndices;
+    QStringList removed;
+    QList<int> addedIndices;
+    QStringList added;
+    QStringList modified;
+    // old -> new name; both are also in removed / added
+    QList<QPair<QString, QString>> renamed;
+
+    bool isEmpty() const {
+        return removed.isEmpty() && added.isEmpty() && modified.isEmpty();
+    }
+
+    // index of a removed file in the old list, -1 if not removed
+    int removedIndexOf(const QString &name) const {
+        int i = removed.indexOf(name);
+        return i >= 0 ? removedIndices.at(i) : -1;
+    }
+
+    QString renamedTo(const QString &name) const {
+        for(auto &rename : renamed) {
+            if(rename.first == name)
+                return rename.second;
+        }
+        return QString();
+    }
+};
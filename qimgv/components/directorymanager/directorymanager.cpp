@@ -1,122 +1,88 @@
 #include "directorymanager.h"
-
-#if defined(QIMGV_BOOST_FS)
-#include <boost/filesystem.hpp>
-#else
-#include <filesystem>
+#ifdef __linux__
+#include "directoryscanner.h"
 #endif
 
+DirectoryManager::~DirectoryManager() {
+    delete watcher;
+}
+
+namespace {
+
+// file type from readdir where the platform gives it, so usually no stat
+bool isDirectoryEntry(const fs::directory_entry &entry) {
 #if defined(QIMGV_BOOST_FS)
-    namespace fs = boost::filesystem;
-    using fs_time_t = std::time_t;
+    boost::system::error_code ec;
+    return fs::is_directory(entry.status(ec));
 #else
-    namespace fs = std::filesystem;
-    using fs_time_t = std::filesystem::file_time_type;
+    std::error_code ec;
+    return entry.is_directory(ec);
 #endif
+}
 
-class Entry {
-public:
-    Entry() { }
-    Entry( QString _path, std::uintmax_t _size, fs_time_t _modifyTime, bool _isDirectory)
-	: path(std::move(_path)),
-	  size(_size),
-	  modifyTime(_modifyTime),
-	  isDirectory(_isDirectory)
-    {
-    }
-    Entry( QString _path, std::uintmax_t _size, bool _isDirectory)
-	: path(std::move(_path)),
-	  size(_size),
-	  isDirectory(_isDirectory)
-    {
-    }
-    Entry( QString _path, bool _isDirectory)
-	: path(std::move(_path)),
-	  isDirectory(_isDirectory)
-    {
-    }
-    Entry( QString _path, const fs::directory_entry& _dEntry );
-    bool operator==(const QString &anotherPath) const {
-	return this->path == anotherPath;
+// runs in a worker thread
+std::vector<Entry> readMetadata(QString directory, std::vector<Entry> list) {
+#ifdef __linux__
+    DirectoryScanner::readMetadata(directory, list);
+#else
+    for(auto &entry : list) {
+        try {
+            entry = Entry(entry.path, fs::directory_entry(toStdString(directory + "/" + entry.path)));
+        } catch (const fs::filesystem_error &err) {
+            qDebug() << "[DirectoryManager]" << err.what();
+        }
     }
-    QString path;
-    std::uintmax_t size;
-    fs_time_t modifyTime;
-    bool isDirectory;
-};
-
-#if defined(QIMGV_BOOST_FS)
-Entry::Entry( QString _path, const fs::directory_entry& _dEntry ):
-    path(std::move(_path)),
-    size(fs::file_size(_dEntry.path())),
-    modifyTime(fs::last_write_time(_dEntry.path())),
-    isDirectory(fs::is_directory(_dEntry.path()))
-{
+#endif
+    return list;
 }
-#else
-Entry::Entry( QString _path, const fs::directory_entry& _dEntry ):
-    path(std::move(_path)),
-    size(_dEntry.file_size()),
-    modifyTime(_dEntry.last_write_time()),
-    isDirectory(_dEntry.is_directory())
 
-{
 }
-#endif
-
-DirectoryManager::~DirectoryManager() = default;
 
-DirectoryManager::DirectoryManager() {
+DirectoryManager::DirectoryManager()
+    : watcher(nullptr),
+      watcherPolling(false),
+      metadataLoaded(false),
+      listGeneration(0),
+      metadataGeneration(0)
+{
     currentPath = "";
 
     regex.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
     collator.setNumericMode(true);
 
-    watcher = DirectoryWatcher::newInstance();
+    changeTimer.setSingleShot(true);
+    changeTimer.setInterval(CHANGE_BATCH_MS);
+    connect(&changeTimer, &QTimer::timeout, this, &DirectoryManager::applyPendingChanges);
 
-    connect(watcher, &DirectoryWatcher::observingStarted, this, [] () {
-    //    qDebug() << "observing started";
-    });
-    connect(watcher, &DirectoryWatcher::observingStopped, this, [] () {
-    //    qDebug() << "observing stopped";
-    });
-    connect(watcher, &DirectoryWatcher::fileCreated, this, [this] (const QString& filename) {
-        //qDebug() << "[w] file created" << filename;
-        onFileAddedExternal(filename);
-    });
-    connect(watcher, &DirectoryWatcher::fileDeleted, this, [this] (const QString& filename) {
-        //qDebug() << "[w] file deleted" << filename;
-        onFileRemovedExternal(filename);
-    });
-    connect(watcher, &DirectoryWatcher::fileModified, this, [this] (const QString& filename) {
-        //qDebug() << "[w] file modified" << filename;
-        onFileModifiedExternal(filename);
-    });
-    connect(watcher, &DirectoryWatcher::fileRenamed, this, [this] (const QString& file1, const QString& file2) {
-        //qDebug() << "[w] file renamed from" << file1 << "to" << file2;
-        onFileRenamedExternal(file1, file2);
-    });
+    connect(&metadataWatcher, &QFutureWatcher<std::vector<Entry>>::finished, this, &DirectoryManager::onMetadataLoaded);
 
     readSettings();
     connect(settings, &Settings::settingsChanged, this, &DirectoryManager::readSettings);
 }
 
-namespace
-{
-template< typename T, typename Pred >
-auto insert_sorted(std::vector<T> & vec, T const& item, Pred pred) {
-    return vec.insert(std::upper_bound(vec.begin(), vec.end(), item, pred), item);
-}
-}
-
+// QCollator::compare() redoes the collation of both strings on every call,
+// so entries carry a precomputed key which just needs a byte comparison
 bool DirectoryManager::name_entry_compare(const Entry &e1, const Entry &e2) const {
+    if(e1.sortKey && e2.sortKey)
+        return e1.sortKey->compare(*e2.sortKey) < 0;
     return collator.compare(e1.path, e2.path) < 0;
 };
 
 bool DirectoryManager::name_entry_compare_reverse(const Entry &e1, const Entry &e2) const {
+    if(e1.sortKey && e2.sortKey)
+        return e1.sortKey->compare(*e2.sortKey) > 0;
     return collator.compare(e1.path, e2.path) > 0;
 };
 
+void DirectoryManager::setSortKey(Entry &entry) const {
+    if(!entry.sortKey)
+        entry.sortKey = collator.sortKey(entry.path);
+}
+
+bool DirectoryManager::sortsByName() const {
+    return mSortingMode == SortingMode::SORT_NAME || mSortingMode == SortingMode::SORT_NAME_DESC;
+}
+
 bool DirectoryManager::date_entry_compare(const Entry& e1, const Entry& e2) {
     return e1.modifyTime < e2.modifyTime;
 }
@@ -161,6 +127,9 @@ DirectoryEntryCompareFunction DirectoryManager::compareFunction() const {
 void DirectoryManager::readSettings() {
     filterRegex = settings->supportedFormatsRegex();
     regex.setPattern(filterRegex);
+    formatSuffixes.clear();
+    for(auto &format : settings->supportedFormats())
+        formatSuffixes.insert(format.toLower());
     setSortingMode(settings->sortingMode());
 }
 
@@ -177,27 +146,55 @@ bool DirectoryManager::setDirectory(QString path) {
         return false;
     }
     currentPath = path;
+    changeTimer.stop();
+    pendingChanges.clear();
+    pendingRenames.clear();
     generateFileList();
-    sortFileList();
     emit loaded(path);
+    // network mounts need a different watcher than the local disk
+    bool polling = DirectoryWatcher::needsPolling(path);
+    if(!watcher || polling != watcherPolling) {
+        delete watcher;
+        watcher = DirectoryWatcher::newInstance(polling);
+        watcherPolling = polling;
+        connectWatcher();
+    }
     watcher->setWatchPath(path);
     watcher->observe();
     return true;
 }
 
+void DirectoryManager::connectWatcher() {
+    connect(watcher, &DirectoryWatcher::observingStarted, this, [] () {
+    //    qDebug() << "observing started";
+    });
+    connect(watcher, &DirectoryWatcher::observingStopped, this, [] () {
+    //    qDebug() << "observing stopped";
+    });
+    connect(watcher, &DirectoryWatcher::fileCreated, this, [this] (const QString& filename) {
+        //qDebug() << "[w] file created" << filename;
+        queueChange(filename);
+    });
+    connect(watcher, &DirectoryWatcher::fileDeleted, this, [this] (const QString& filename) {
+        //qDebug() << "[w] file deleted" << filename;
+        queueChange(filename);
+    });
+    connect(watcher, &DirectoryWatcher::fileModified, this, [this] (const QString& filename) {
+        //qDebug() << "[w] file modified" << filename;
+        queueChange(filename);
+    });
+    connect(watcher, &DirectoryWatcher::fileRenamed, this, [this] (const QString& file1, const QString& file2) {
+        //qDebug() << "[w] file renamed from" << file1 << "to" << file2;
+        queueRename(file1, file2);
+    });
+}
+
 QString DirectoryManager::directory() const {
     return currentPath;
 }
 
 int DirectoryManager::indexOf(QString fileName) const {
-    auto item = find_if(entryVec.begin(), entryVec.end(), [fileName](const Entry& e) {
-        return e.path == fileName;
-    });
-
-    if(item != entryVec.end()) {
-        return distance(entryVec.begin(), item);
-    }
-    return -1;
+    return entries.indexOf(fileName);
 }
 
 QString DirectoryManager::absolutePath() const {
@@ -205,7 +202,7 @@ QString DirectoryManager::absolutePath() const {
 }
 
 QString DirectoryManager::filePathAt(int index) const {
-    return checkRange(index) ? currentPath + "/" + entryVec.at(index).path : "";
+    return checkRange(index) ? currentPath + "/" + entries.at(index).path : "";
 }
 
 // dumb. maybe better to store full paths in Entry right away
@@ -214,20 +211,20 @@ QString DirectoryManager::fullFilePath(QString fileName) const {
 }
 
 QString DirectoryManager::fileNameAt(int index) const {
-    return checkRange(index) ? entryVec.at(index).path : "";
+    return checkRange(index) ? entries.at(index).path : "";
 }
 
 QString DirectoryManager::first() {
     QString fileName = "";
-    if(entryVec.size())
-        fileName = entryVec.front().path;
+    if(!entries.isEmpty())
+        fileName = entries.at(0).path;
     return fileName;
 }
 
 QString DirectoryManager::last() {
     QString fileName = "";
-    if(entryVec.size())
-        fileName = entryVec.back().path;
+    if(!entries.isEmpty())
+        fileName = entries.at(entries.count() - 1).path;
     return fileName;
 }
 
@@ -235,15 +232,15 @@ QString DirectoryManager::prevOf(QString fileName) const {
     QString prevFileName = "";
     int currentIndex = indexOf(fileName);
     if(currentIndex > 0)
-        prevFileName = entryVec.at(currentIndex - 1).path;
+        prevFileName = entries.at(currentIndex - 1).path;
     return prevFileName;
 }
 
 QString DirectoryManager::nextOf(QString fileName) const {
     QString nextFileName = "";
     int currentIndex = indexOf(fileName);
-    if(currentIndex >= 0 && currentIndex < int(entryVec.size()) - 1)
-        nextFileName = entryVec.at(currentIndex + 1).path;
+    if(currentIndex >= 0 && currentIndex < entries.count() - 1)
+        nextFileName = entries.at(currentIndex + 1).path;
     return nextFileName;
 }
 
@@ -252,14 +249,13 @@ bool DirectoryManager::removeFile(QString fileName, bool trash) {
         return false;
     QString path = fullFilePath(fileName);
     QFile file(path);
-    int index = indexOf(fileName);
     if(trash) {
-        entryVec.erase(entryVec.begin() + index);
+        int index = entries.remove(fileName);
         moveToTrash(path);
         emit fileRemoved(fileName, index);
         return true;
     } else if(file.remove()) {
-        entryVec.erase(entryVec.begin() + index);
+        int index = entries.remove(fileName);
         emit fileRemoved(fileName, index);
         return true;
     }
@@ -371,7 +367,7 @@ void DirectoryManager::moveToTrash(QString file) {
 #endif
 
 bool DirectoryManager::checkRange(int index) const {
-    return index >= 0 && index < (int)entryVec.size();
+    return index >= 0 && index < entries.count();
 }
 
 bool DirectoryManager::copyTo(QString destDirectory, QString fileName) {
@@ -381,7 +377,7 @@ bool DirectoryManager::copyTo(QString destDirectory, QString fileName) {
 }
 
 unsigned long DirectoryManager::fileCount() const {
-    return entryVec.size();
+    return static_cast<unsigned long>(entries.count());
 }
 
 bool DirectoryManager::isDirectory(QString path) const {
@@ -412,23 +408,46 @@ bool DirectoryManager::isFile(QString path) const {
 }
 
 bool DirectoryManager::isEmpty() const {
-    return entryVec.empty();
+    return entries.isEmpty();
 }
 
 bool DirectoryManager::contains(QString fileName) const {
-    return (std::find(entryVec.begin(), entryVec.end(), fileName) != entryVec.end());
+    return entries.contains(fileName);
 }
 
 // ##############################################################
 // ###################### PRIVATE METHODS #######################
 // ##############################################################
+// Name sorting doesn't need a stat per file, which is slow on network mounts.
+// Sizes and times are then read in the background when a sorting mode needs them.
 void DirectoryManager::generateFileList() {
-    entryVec.clear();
+    std::vector<Entry> entryVec;
+    listGeneration++;
+    metadataLoaded = needsMetadata(mSortingMode);
+    bool scanned = false;
+#ifdef __linux__
+    scanned = DirectoryScanner::scan(currentPath, formatSuffixes, metadataLoaded, entryVec);
+#endif
+    if(!scanned)
+        listDirectory(entryVec);
+    if(sortsByName()) {
+        for(auto &entry : entryVec)
+            setSortKey(entry);
+    }
+    sort(entryVec.begin(), entryVec.end(), compareFunction());
+    entries.assign(std::move(entryVec));
+}
+
+void DirectoryManager::listDirectory(std::vector<Entry> &entryVec) {
     QRegularExpressionMatch match;
     for(const auto & entry : fs::directory_iterator(toStdString(currentPath))) {
         QString name = QString::fromStdString(entry.path().filename().string());
         match = regex.match(name);
         if(match.hasMatch()) {
+            if(!metadataLoaded) {
+                entryVec.emplace_back(Entry(std::move(name), isDirectoryEntry(entry)));
+                continue;
+            }
             Entry newEntry;
             try {
 		newEntry = Entry(std::move(name),entry);
@@ -437,104 +456,176 @@ void DirectoryManager::generateFileList() {
                 continue;
             }
             entryVec.emplace_back(newEntry);
-            /* It is probably worth implementing lazy loading in future.
-             * Read names only, and other stuff ondemand.
-             * This would give ~2x load speedup when we are just sorting by filename.
-             */
-            //entryVec.emplace_back(Entry(name, entry.is_directory()));
         }
     }
 }
 
 void DirectoryManager::sortFileList() {
+    std::vector<Entry> entryVec = entries.toVector();
+    if(sortsByName()) {
+        for(auto &entry : entryVec)
+            setSortKey(entry);
+    }
     sort(entryVec.begin(), entryVec.end(), compareFunction());
+    entries.assign(std::move(entryVec));
 }
 
 void DirectoryManager::setSortingMode(SortingMode mode) {
     if(mode != mSortingMode) {
         mSortingMode = mode;
-        if(entryVec.size() > 1) {
+        if(entries.count() > 1) {
+            // sorted once sizes & times are in
+            if(needsMetadata(mode) && !metadataLoaded) {
+                loadMetadataAsync();
+                return;
+            }
             sortFileList();
             emit sortingChanged();
         }
     }
 }
 
-SortingMode DirectoryManager::sortingMode() {
-    return mSortingMode;
+bool DirectoryManager::needsMetadata(SortingMode mode) {
+    return mode != SortingMode::SORT_NAME && mode != SortingMode::SORT_NAME_DESC;
 }
 
-// fs watcher events
-
-void DirectoryManager::onFileRemovedExternal(QString fileName) {
-    if(!contains(fileName))
+void DirectoryManager::loadMetadataAsync() {
+    if(metadataWatcher.isRunning() && metadataGeneration == listGeneration)
         return;
+    metadataGeneration = listGeneration;
+    metadataWatcher.setFuture(QtConcurrent::run(readMetadata, currentPath, entries.toVector()));
+}
 
-    QFile file(fullFilePath(fileName));
-    if(file.exists())
+void DirectoryManager::onMetadataLoaded() {
+    // directory got reloaded in the meantime
+    if(metadataGeneration != listGeneration)
         return;
-
-    int index = indexOf(fileName);
-    entryVec.erase(entryVec.begin() + index);
-    emit fileRemoved(fileName, index);
+    for(auto &loaded : metadataWatcher.result()) {
+        Entry *entry = entries.find(loaded.path);
+        // added by the watcher meanwhile; those have metadata already
+        if(entry && !entry->hasMetadata) {
+            entry->size = loaded.size;
+            entry->modifyTime = loaded.modifyTime;
+            entry->isDirectory = loaded.isDirectory;
+            entry->hasMetadata = loaded.hasMetadata;
+        }
+    }
+    metadataLoaded = true;
+    if(needsMetadata(mSortingMode) && entries.count() > 1) {
+        sortFileList();
+        emit sortingChanged();
+    }
 }
 
-void DirectoryManager::onFileAddedExternal(QString fileName) {
-    QString fullPath = fullFilePath(fileName);
-    if(!this->isSupportedFile(fullPath))
-        return;
-    if(this->contains(fileName))
-        onFileModifiedExternal(fileName);
-    fs::directory_entry stdEntry(toStdString(fullPath));
-    Entry entry(fileName, stdEntry);
-    insert_sorted(entryVec, entry, compareFunction() );
-    emit fileAdded(fileName);
-    return;
+SortingMode DirectoryManager::sortingMode() {
+    return mSortingMode;
 }
 
-void DirectoryManager::onFileRenamedExternal(QString oldFile, QString newFile) {
-    if(!contains(oldFile)) {
-        if(contains(newFile))
-            onFileModifiedExternal(newFile);
-        else
-            onFileAddedExternal(newFile);
+// fs watcher events
+
+void DirectoryManager::queueChange(const QString &fileName) {
+    pendingChanges.insert(fileName);
+    // the window starts at the first event, so a steady stream still gets through
+    if(!changeTimer.isActive())
+        changeTimer.start();
+}
+
+void DirectoryManager::queueRename(const QString &oldFile, const QString &newFile) {
+    // a -> b -> c is still a rename of a
+    QString origin = pendingRenames.take(oldFile);
+    pendingRenames.insert(newFile, origin.isEmpty() ? oldFile : origin);
+    queueChange(oldFile);
+    queueChange(newFile);
+}
+
+// What happened to a file is decided by what is on disk now,
+// so events that cancel each other out within a batch cost nothing.
+void DirectoryManager::applyPendingChanges() {
+    QSet<QString> names;
+    names.swap(pendingChanges);
+    QHash<QString, QString> renames;
+    renames.swap(pendingRenames);
+
+    DirectoryChanges changes;
+    std::vector<Entry> added;
+    QSet<QString> removedNames, addedNames;
+    for(auto &name : names) {
+        bool listed = contains(name);
+        QString fullPath = fullFilePath(name);
+        if(!isSupportedFile(fullPath)) {
+            if(listed)
+                removedNames.insert(name);
+            continue;
+        }
+        Entry entry;
+        try {
+            entry = Entry(name, fs::directory_entry(toStdString(fullPath)));
+        } catch (const fs::filesystem_error &err) {
+            qDebug() << "[DirectoryManager]" << err.what();
+            continue;
+        }
+        if(listed) {
+            // keeps its position, reordering would confuse the views
+            Entry *existing = entries.find(name);
+            existing->modifyTime = entry.modifyTime;
+            changes.modified.append(name);
+        } else {
+            setSortKey(entry);
+            addedNames.insert(name);
+            added.push_back(std::move(entry));
+        }
+    }
+    if(removedNames.isEmpty() && added.empty() && changes.modified.isEmpty())
         return;
+
+    // removals, by index in the old list
+    std::vector<QPair<int, QString>> removedList;
+    for(auto &name : removedNames)
+        removedList.push_back(qMakePair(entries.indexOf(name), name));
+    std::sort(removedList.begin(), removedList.end(), [](const QPair<int, QString> &a, const QPair<int, QString> &b) {
+        return a.first > b.first;
+    });
+    for(auto &removed : removedList) {
+        changes.removedIndices.append(removed.first);
+        changes.removed.append(removed.second);
     }
 
-    QString fullPath = fullFilePath(newFile);
-    if(!this->isSupportedFile(fullPath)) {
-        onFileRemovedExternal(oldFile);
-        return;
+    auto compare = compareFunction();
+    if(static_cast<int>(removedNames.size()) + static_cast<int>(added.size()) < MERGE_MIN_CHANGES) {
+        for(auto &name : changes.removed)
+            entries.remove(name);
+        for(auto &entry : added)
+            entries.insert(entry, compare);
+    } else {
+        std::vector<Entry> kept = entries.toVector();
+        kept.erase(std::remove_if(kept.begin(), kept.end(), [&removedNames](const Entry &entry) {
+            return removedNames.contains(entry.path);
+        }), kept.end());
+        std::stable_sort(added.begin(), added.end(), compare);
+        std::vector<Entry> merged;
+        merged.reserve(kept.size() + added.size());
+        std::merge(std::make_move_iterator(kept.begin()), std::make_move_iterator(kept.end()),
+                   added.begin(), added.end(), std::back_inserter(merged), compare);
+        entries.assign(std::move(merged));
     }
-    if(contains(newFile)) {
-        int replaceIndex = indexOf(newFile);
-        entryVec.erase(entryVec.begin() + replaceIndex);
-        emit fileRemoved(newFile, replaceIndex);
+
+    // insertions, by index in the new list
+    std::vector<QPair<int, QString>> addedList;
+    for(auto &entry : added)
+        addedList.push_back(qMakePair(entries.indexOf(entry.path), entry.path));
+    std::sort(addedList.begin(), addedList.end(), [](const QPair<int, QString> &a, const QPair<int, QString> &b) {
+        return a.first < b.first;
+    });
+    for(auto &add : addedList) {
+        changes.addedIndices.append(add.first);
+        changes.added.append(add.second);
     }
-    // remove the old one
-    int oldIndex = indexOf(oldFile);
-    entryVec.erase(entryVec.begin() + oldIndex);
-    // insert
-    fs::directory_entry stdEntry(toStdString(fullPath));
-    Entry entry(newFile, stdEntry);
-    insert_sorted(entryVec, entry, compareFunction() );
-    emit fileRenamed(oldFile, oldIndex, newFile, indexOf(newFile));
-}
 
-void DirectoryManager::onFileModifiedExternal(QString fileName) {
-    if(!contains(fileName))
-        return;
-    QString fullPath = fullFilePath(fileName);
-    fs::directory_entry stdEntry(toStdString(fullPath));
-    int index = indexOf(fileName);
-#if defined(QIMGV_BOOST_FS)
-    if(entryVec.at(index).modifyTime != last_write_time(stdEntry.path()))
-	entryVec.at(index).modifyTime = last_write_time(stdEntry.path());
-#else
-    if(entryVec.at(index).modifyTime != stdEntry.last_write_time())
-	entryVec.at(index).modifyTime = stdEntry.last_write_time();
-#endif
-    emit fileModified(fileName);
+    for(auto i = renames.constBegin(); i != renames.constEnd(); ++i) {
+        if(removedNames.contains(i.value()) && addedNames.contains(i.key()))
+            changes.renamed.append(qMakePair(i.value(), i.key()));
+    }
+    emit filesChanged(changes);
 }
 
 bool DirectoryManager::forceInsert(QString fileName) {
@@ -543,7 +634,8 @@ bool DirectoryManager::forceInsert(QString fileName) {
         return false;
     fs::directory_entry stdEntry(toStdString(fullPath));
     Entry entry(fileName, stdEntry);
-    insert_sorted(entryVec, entry, compareFunction() );
+    setSortKey(entry);
+    entries.insert(entry, compareFunction());
     emit fileAdded(fileName);
     return true;
 }
@@ -8,16 +8,23 @@
 #include <QDebug>
 #include <QDateTime>
 #include <QRegularExpression>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QSet>
+#include <QtConcurrent>
 
 #include <vector>
 #include <string>
 #include <iostream>
 #include <algorithm>
+#include <iterator>
 #include <functional>
 //#include <experimental/filesystem>
 
 #include "settings.h"
 #include "watchers/directorywatcher.h"
+#include "entryindex.h"
+#include "directorychanges.h"
 #include "utils/stuff.h"
 
 #ifdef Q_OS_WIN32
@@ -25,7 +32,6 @@
 #endif
 
 class DirectoryManager;
-class Entry;
 
 using DirectoryEntryCompareFunction = std::function<bool(const Entry &a, const Entry &b)>;
 
@@ -67,18 +73,39 @@ private:
     QString currentPath;
     QString filterRegex;
     QRegularExpression regex;
+    // same formats as the regex, lowercase
+    QSet<QByteArray> formatSuffixes;
     QCollator collator;
-    std::vector<Entry> entryVec;
+    EntryIndex entries;
 
     DirectoryWatcher* watcher;
+    bool watcherPolling;
+    void connectWatcher();
     void readSettings();
     SortingMode mSortingMode;
     void generateFileList();
+    void listDirectory(std::vector<Entry> &entryVec);
 
-    void onFileAddedExternal(QString filename);
-    void onFileRemovedExternal(QString);
-    void onFileModifiedExternal(QString fileName);
-    void onFileRenamedExternal(QString oldFile, QString newFile);
+    // size & time of entries that were listed by name only
+    bool metadataLoaded;
+    // bumped on every listing, so that stale metadata gets dropped
+    quint64 listGeneration, metadataGeneration;
+    QFutureWatcher<std::vector<Entry>> metadataWatcher;
+    static bool needsMetadata(SortingMode mode);
+    void loadMetadataAsync();
+    void onMetadataLoaded();
+
+    // watcher events are collected for a short while and applied together
+    QTimer changeTimer;
+    QSet<QString> pendingChanges;
+    // new name -> name before the first rename in this batch
+    QHash<QString, QString> pendingRenames;
+    static const int CHANGE_BATCH_MS = 100;
+    // bigger batches rebuild the list with one merge
+    static const int MERGE_MIN_CHANGES = 64;
+    void queueChange(const QString &fileName);
+    void queueRename(const QString &oldFile, const QString &newFile);
+    void applyPendingChanges();
     void moveToTrash(QString file);
     bool name_entry_compare(const Entry &e1, const Entry &e2) const;
     bool name_entry_compare_reverse(const Entry &e1, const Entry &e2) const;
@@ -87,12 +114,14 @@ private:
     static bool size_entry_compare(const Entry &e1, const Entry &e2);
     static bool size_entry_compare_reverse(const Entry &e1, const Entry &e2);
     bool entryCompareString(Entry &e, QString path);
+    void setSortKey(Entry &entry) const;
+    bool sortsByName() const;
     DirectoryEntryCompareFunction compareFunction() const;
 signals:
     void loaded(const QString &path);
     void sortingChanged();
     void fileRemoved(QString, int);
-    void fileModified(QString);
     void fileAdded(QString);
-    void fileRenamed(QString from, int indexFrom, QString to, int indexTo);
+    // external changes, in batches
+    void filesChanged(const DirectoryChanges &changes);
 };
@@ -0,0 +1,251 @@
+#include "directoryscanner.h"
+#include <QFile>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QDebug>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+namespace {
+
+const size_t DENTS_BUFFER_SIZE = 256 * 1024;
+// files handed to a thread at once
+const int STAT_BATCH = 64;
+// below this the threads cost more than they save
+const int PARALLEL_MIN_STATS = 256;
+// stat is mostly waiting on the disk or the server, not cpu
+const int STAT_THREADS = 16;
+
+struct Candidate {
+    QByteArray name;
+    unsigned char type;
+    // filled by stat
+    bool ok;
+    bool isFile;
+    std::uintmax_t size;
+    struct timespec mtime;
+};
+
+struct StatJob {
+    int dirFd;
+    bool withMetadata;
+    std::vector<Candidate*> list;
+    std::atomic_int next;
+};
+
+bool statAt(int dirFd, Candidate &c, bool withMetadata) {
+#ifdef STATX_BASIC_STATS
+    static std::atomic_bool noStatx(false);
+    if(!noStatx) {
+        struct statx stx;
+        unsigned int mask = withMetadata ? (STATX_TYPE | STATX_SIZE | STATX_MTIME) : STATX_TYPE;
+        if(statx(dirFd, c.name.constData(), AT_STATX_SYNC_AS_STAT, mask, &stx) == 0) {
+            c.isFile = S_ISREG(stx.stx_mode);
+            c.size = stx.stx_size;
+            c.mtime.tv_sec = stx.stx_mtime.tv_sec;
+            c.mtime.tv_nsec = stx.stx_mtime.tv_nsec;
+            return true;
+        }
+        if(errno != ENOSYS)
+            return false;
+        noStatx = true;
+    }
+#endif
+    Q_UNUSED(withMetadata)
+    struct stat st;
+    if(fstatat(dirFd, c.name.constData(), &st, 0) != 0)
+        return false;
+    c.isFile = S_ISREG(st.st_mode);
+    c.size = static_cast<std::uintmax_t>(st.st_size);
+    c.mtime = st.st_mtim;
+    return true;
+}
+
+void statBatches(StatJob &job) {
+    const int count = static_cast<int>(job.list.size());
+    int first;
+    while((first = job.next.fetch_add(STAT_BATCH)) < count) {
+        int last = std::min(first + STAT_BATCH, count);
+        for(int i = first; i < last; i++)
+            job.list[i]->ok = statAt(job.dirFd, *job.list[i], job.withMetadata);
+    }
+}
+
+class StatTask : public QRunnable {
+public:
+    StatTask(StatJob &job, QSemaphore &done) : job(job), done(done) {}
+    void run() override {
+        statBatches(job);
+        done.release();
+    }
+private:
+    StatJob &job;
+    QSemaphore &done;
+};
+
+QThreadPool *scannerPool() {
+    static QThreadPool pool;
+    static bool init = [] {
+        pool.setMaxThreadCount(STAT_THREADS);
+        return true;
+    }();
+    Q_UNUSED(init)
+    return &pool;
+}
+
+// stats everything in list; same pattern as the resampler
+void statAll(int dirFd, std::vector<Candidate*> &&list, bool withMetadata) {
+    StatJob job;
+    job.dirFd = dirFd;
+    job.withMetadata = withMetadata;
+    job.list = std::move(list);
+    job.next = 0;
+    QSemaphore done;
+    int helpers = 0;
+    if(static_cast<int>(job.list.size()) >= PARALLEL_MIN_STATS) {
+        int batches = (static_cast<int>(job.list.size()) + STAT_BATCH - 1) / STAT_BATCH;
+        int wanted = std::min(scannerPool()->maxThreadCount(), batches - 1);
+        for(; helpers < wanted; helpers++) {
+            auto task = new StatTask(job, done);
+            if(!scannerPool()->tryStart(task)) {
+                delete task;
+                break;
+            }
+        }
+    }
+    statBatches(job);
+    done.acquire(helpers);
+}
+
+fs_time_t toFileTime(const struct timespec &ts) {
+#if defined(QIMGV_BOOST_FS)
+    return ts.tv_sec;
+#else
+    using namespace std::chrono;
+    // file_time_type's clock has its own epoch, a whole number of seconds away from the system one
+    static const auto offset = round<seconds>(fs::file_time_type::clock::now().time_since_epoch()
+                                              - system_clock::now().time_since_epoch());
+    auto sinceEpoch = seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec) + offset;
+    return fs_time_t(duration_cast<fs_time_t::duration>(sinceEpoch));
+#endif
+}
+
+// lowercase ascii part after the last dot
+bool hasSuffix(const char *name, size_t length, const QSet<QByteArray> &suffixes) {
+    const char *dot = static_cast<const char*>(memrchr(name, '.', length));
+    if(!dot || dot == name + length - 1)
+        return false;
+    char buf[16];
+    size_t suffixLength = static_cast<size_t>(name + length - dot - 1);
+    if(suffixLength > sizeof(buf))
+        return false;
+    for(size_t i = 0; i < suffixLength; i++) {
+        char ch = dot[1 + i];
+        buf[i] = (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + ('a' - 'A')) : ch;
+    }
+    return suffixes.contains(QByteArray::fromRawData(buf, static_cast<int>(suffixLength)));
+}
+
+} // namespace
+
+bool DirectoryScanner::scan(const QString &path, const QSet<QByteArray> &suffixes, bool withMetadata, std::vector<Entry> &entries) {
+    int dirFd = open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(dirFd < 0)
+        return false;
+    std::vector<Candidate> candidates;
+    std::vector<char> buffer(DENTS_BUFFER_SIZE);
+    for(;;) {
+        long read = syscall(SYS_getdents64, dirFd, buffer.data(), buffer.size());
+        if(read < 0) {
+            qDebug() << "[DirectoryScanner] getdents64 failed:" << strerror(errno);
+            close(dirFd);
+            return false;
+        }
+        if(read == 0)
+            break;
+        for(long pos = 0; pos < read;) {
+            auto dent = reinterpret_cast<const struct dirent64*>(buffer.data() + pos);
+            pos += dent->d_reclen;
+            size_t length = strlen(dent->d_name);
+            // also drops "." and ".."
+            if(!hasSuffix(dent->d_name, length, suffixes))
+                continue;
+            switch(dent->d_type) {
+            case DT_FIFO:
+            case DT_SOCK:
+            case DT_CHR:
+            case DT_BLK:
+                continue;
+            default:
+                break;
+            }
+            Candidate c;
+            c.name = QByteArray(dent->d_name, static_cast<int>(length));
+            c.type = dent->d_type;
+            c.ok = false;
+            c.isFile = (dent->d_type == DT_REG);
+            c.size = 0;
+            c.mtime = {};
+            candidates.push_back(std::move(c));
+        }
+    }
+
+    // symlinks & filesystems without d_type always need a stat for the type
+    std::vector<Candidate*> toStat;
+    for(auto &c : candidates) {
+        if(withMetadata || c.type == DT_LNK || c.type == DT_UNKNOWN)
+            toStat.push_back(&c);
+        else
+            c.ok = true;
+    }
+    statAll(dirFd, std::move(toStat), withMetadata);
+    close(dirFd);
+
+    entries.reserve(entries.size() + candidates.size());
+    for(auto &c : candidates) {
+        if(!c.ok)
+            continue;
+        QString name = QString::fromUtf8(c.name);
+        if(withMetadata) {
+            // same as directory_entry::file_size(), which fails on anything else
+            if(c.isFile)
+                entries.emplace_back(Entry(std::move(name), c.size, toFileTime(c.mtime), false));
+        } else {
+            entries.emplace_back(Entry(std::move(name), !c.isFile));
+        }
+    }
+    return true;
+}
+
+void DirectoryScanner::readMetadata(const QString &path, std::vector<Entry> &entries) {
+    int dirFd = open(QFile::encodeName(path).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(dirFd < 0)
+        return;
+    std::vector<Candidate> candidates(entries.size());
+    std::vector<Candidate*> toStat;
+    toStat.reserve(entries.size());
+    for(size_t i = 0; i < entries.size(); i++) {
+        candidates[i].name = entries[i].path.toUtf8();
+        candidates[i].ok = false;
+        toStat.push_back(&candidates[i]);
+    }
+    statAll(dirFd, std::move(toStat), true);
+    close(dirFd);
+    for(size_t i = 0; i < entries.size(); i++) {
+        const Candidate &c = candidates[i];
+        if(!c.ok)
+            continue;
+        entries[i].size = c.size;
+        entries[i].modifyTime = toFileTime(c.mtime);
+        entries[i].isDirectory = !c.isFile;
+        entries[i].hasMetadata = true;
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QSet>
+#include <vector>
+#include "entry.h"
+
+// Linux directory listing for big and/or remote directories.
+// Reads entries with getdents64 in large batches and filters them by suffix
+// before anything else; d_type saves a stat in the name-only case. Files which
+// do need a stat (for metadata, or because their type is unknown) get one statx
+// each, spread over a thread pool since on network mounts every stat is a round trip.
+class DirectoryScanner {
+public:
+    // suffixes: lowercase, without the dot. Output is unsorted.
+    // false if the directory couldn't be read, so the caller can fall back
+    static bool scan(const QString &path, const QSet<QByteArray> &suffixes, bool withMetadata, std::vector<Entry> &entries);
+    // fills in size & time of the given entries
+    static void readMetadata(const QString &path, std::vector<Entry> &entries);
+};
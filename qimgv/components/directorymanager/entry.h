@@ -0,0 +1,80 @@
+#pragma once
+
+#include <QString>
+#include <QCollatorSortKey>
+#include <optional>
+
+#if defined(QIMGV_BOOST_FS)
+#include <boost/filesystem.hpp>
+#else
+#include <filesystem>
+#endif
+
+#if defined(QIMGV_BOOST_FS)
+    namespace fs = boost::filesystem;
+    using fs_time_t = std::time_t;
+#else
+    namespace fs = std::filesystem;
+    using fs_time_t = std::filesystem::file_time_type;
+#endif
+
+class Entry {
+public:
+    Entry() { }
+    Entry( QString _path, std::uintmax_t _size, fs_time_t _modifyTime, bool _isDirectory)
+	: path(std::move(_path)),
+	  size(_size),
+	  modifyTime(_modifyTime),
+	  isDirectory(_isDirectory),
+	  hasMetadata(true)
+    {
+    }
+    Entry( QString _path, std::uintmax_t _size, bool _isDirectory)
+	: path(std::move(_path)),
+	  size(_size),
+	  isDirectory(_isDirectory),
+	  hasMetadata(false)
+    {
+    }
+    // name only, size & time are filled in later if needed
+    Entry( QString _path, bool _isDirectory)
+	: path(std::move(_path)),
+	  size(0),
+	  modifyTime(),
+	  isDirectory(_isDirectory),
+	  hasMetadata(false)
+    {
+    }
+    Entry( QString _path, const fs::directory_entry& _dEntry );
+    bool operator==(const QString &anotherPath) const {
+	return this->path == anotherPath;
+    }
+    QString path;
+    std::uintmax_t size;
+    fs_time_t modifyTime;
+    bool isDirectory;
+    // false if only the name was read
+    bool hasMetadata;
+    // collation key of path, set while sorting by name
+    std::optional<QCollatorSortKey> sortKey;
+};
+
+#if defined(QIMGV_BOOST_FS)
+inline Entry::Entry( QString _path, const fs::directory_entry& _dEntry ):
+    path(std::move(_path)),
+    size(fs::file_size(_dEntry.path())),
+    modifyTime(fs::last_write_time(_dEntry.path())),
+    isDirectory(fs::is_directory(_dEntry.path())),
+    hasMetadata(true)
+{
+}
+#else
+inline Entry::Entry( QString _path, const fs::directory_entry& _dEntry ):
+    path(std::move(_path)),
+    size(_dEntry.file_size()),
+    modifyTime(_dEntry.last_write_time()),
+    isDirectory(_dEntry.is_directory()),
+    hasMetadata(true)
+{
+}
+#endif
@@ -0,0 +1,229 @@
+#include "entryindex.h"
+
+EntryIndex::EntryIndex() : root(-1), random(0x5eed) {
+}
+
+void EntryIndex::clear() {
+    nodes.clear();
+    freeNodes.clear();
+    byName.clear();
+    root = -1;
+}
+
+// Builds the treap in one pass (cartesian tree on the priorities).
+void EntryIndex::assign(std::vector<Entry> &&sorted) {
+    clear();
+    nodes.reserve(sorted.size());
+    byName.reserve(static_cast<int>(sorted.size()));
+    std::vector<int> stack;
+    for(auto &entry : sorted) {
+        int n = newNode(entry);
+        int last = -1;
+        while(!stack.empty() && nodes[stack.back()].priority < nodes[n].priority) {
+            last = stack.back();
+            stack.pop_back();
+        }
+        nodes[n].left = last;
+        setParent(last, n);
+        if(!stack.empty()) {
+            nodes[stack.back()].right = n;
+            nodes[n].parent = stack.back();
+        }
+        stack.push_back(n);
+    }
+    sorted.clear();
+    root = stack.empty() ? -1 : stack.front();
+    updateSizes(root);
+}
+
+std::vector<Entry> EntryIndex::toVector() const {
+    std::vector<Entry> list;
+    list.reserve(static_cast<size_t>(count()));
+    std::vector<int> stack;
+    int n = root;
+    while(n >= 0 || !stack.empty()) {
+        while(n >= 0) {
+            stack.push_back(n);
+            n = nodes[n].left;
+        }
+        n = stack.back();
+        stack.pop_back();
+        list.push_back(nodes[n].entry);
+        n = nodes[n].right;
+    }
+    return list;
+}
+
+int EntryIndex::count() const {
+    return sizeOf(root);
+}
+
+bool EntryIndex::isEmpty() const {
+    return root < 0;
+}
+
+bool EntryIndex::contains(const QString &name) const {
+    return byName.contains(name);
+}
+
+int EntryIndex::indexOf(const QString &name) const {
+    auto it = byName.find(name);
+    if(it == byName.end())
+        return -1;
+    return rankOf(it.value());
+}
+
+const Entry &EntryIndex::at(int index) const {
+    return nodes[nodeAt(index)].entry;
+}
+
+Entry *EntryIndex::find(const QString &name) {
+    auto it = byName.find(name);
+    if(it == byName.end())
+        return nullptr;
+    return &nodes[it.value()].entry;
+}
+
+int EntryIndex::insert(const Entry &entry, const Compare &less) {
+    // upper bound, same as the sorted vector insert it replaces
+    int index = 0;
+    int n = root;
+    while(n >= 0) {
+        if(less(entry, nodes[n].entry)) {
+            n = nodes[n].left;
+        } else {
+            index += sizeOf(nodes[n].left) + 1;
+            n = nodes[n].right;
+        }
+    }
+    int node = newNode(entry);
+    int l, r;
+    split(root, index, l, r);
+    root = merge(merge(l, node), r);
+    setParent(root, -1);
+    return index;
+}
+
+int EntryIndex::remove(const QString &name) {
+    auto it = byName.find(name);
+    if(it == byName.end())
+        return -1;
+    int n = it.value();
+    byName.erase(it);
+    int index = rankOf(n);
+    int l, m, r;
+    split(root, index, l, r);
+    split(r, 1, m, r);
+    root = merge(l, r);
+    setParent(root, -1);
+    // drop the string now, the slot is reused later
+    nodes[n].entry = Entry(QString(), false);
+    freeNodes.push_back(n);
+    return index;
+}
+
+int EntryIndex::sizeOf(int n) const {
+    return n < 0 ? 0 : nodes[n].size;
+}
+
+void EntryIndex::update(int n) {
+    nodes[n].size = 1 + sizeOf(nodes[n].left) + sizeOf(nodes[n].right);
+}
+
+void EntryIndex::setParent(int n, int parent) {
+    if(n >= 0)
+        nodes[n].parent = parent;
+}
+
+int EntryIndex::rankOf(int n) const {
+    int rank = sizeOf(nodes[n].left);
+    for(int p = nodes[n].parent; p >= 0; n = p, p = nodes[p].parent) {
+        if(nodes[p].right == n)
+            rank += sizeOf(nodes[p].left) + 1;
+    }
+    return rank;
+}
+
+int EntryIndex::nodeAt(int index) const {
+    int n = root;
+    while(n >= 0) {
+        int leftSize = sizeOf(nodes[n].left);
+        if(index < leftSize) {
+            n = nodes[n].left;
+        } else if(index == leftSize) {
+            return n;
+        } else {
+            index -= leftSize + 1;
+            n = nodes[n].right;
+        }
+    }
+    return n;
+}
+
+int EntryIndex::newNode(const Entry &entry) {
+    int n;
+    if(freeNodes.empty()) {
+        n = static_cast<int>(nodes.size());
+        nodes.resize(nodes.size() + 1);
+    } else {
+        n = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    Node &node = nodes[n];
+    node.entry = entry;
+    node.left = node.right = node.parent = -1;
+    node.size = 1;
+    node.priority = random();
+    byName.insert(node.entry.path, n);
+    return n;
+}
+
+// first k entries of t go to l, the rest to r
+void EntryIndex::split(int t, int k, int &l, int &r) {
+    if(t < 0) {
+        l = r = -1;
+        return;
+    }
+    if(sizeOf(nodes[t].left) < k) {
+        int right;
+        split(nodes[t].right, k - sizeOf(nodes[t].left) - 1, right, r);
+        nodes[t].right = right;
+        setParent(right, t);
+        l = t;
+    } else {
+        int left;
+        split(nodes[t].left, k, l, left);
+        nodes[t].left = left;
+        setParent(left, t);
+        r = t;
+    }
+    update(t);
+    setParent(l, -1);
+    setParent(r, -1);
+}
+
+int EntryIndex::merge(int a, int b) {
+    if(a < 0)
+        return b;
+    if(b < 0)
+        return a;
+    if(nodes[a].priority > nodes[b].priority) {
+        int right = merge(nodes[a].right, b);
+        nodes[a].right = right;
+        setParent(right, a);
+        update(a);
+        return a;
+    }
+    int left = merge(a, nodes[b].left);
+    nodes[b].left = left;
+    setParent(left, b);
+    update(b);
+    return b;
+}
+
+int EntryIndex::updateSizes(int n) {
+    if(n < 0)
+        return 0;
+    nodes[n].size = 1 + updateSizes(nodes[n].left) + updateSizes(nodes[n].right);
+    return nodes[n].size;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <vector>
+#include <random>
+#include <functional>
+#include "entry.h"
+
+/* Directory listing that stays fast for huge folders.
+ * Entries live in a treap ordered by position (sorting order), so index <-> entry
+ * and sorted inserts / removals are O(log n). A hash on the file name finds
+ * the node in O(1). The name string is shared between the hash key and the entry.
+ * Nodes are kept in one array and linked by index; freed slots get reused.
+ */
+class EntryIndex {
+public:
+    using Compare = std::function<bool(const Entry &a, const Entry &b)>;
+
+    EntryIndex();
+    void clear();
+    // replaces contents with an already sorted list, O(n)
+    void assign(std::vector<Entry> &&sorted);
+    // all entries in order
+    std::vector<Entry> toVector() const;
+
+    int count() const;
+    bool isEmpty() const;
+    bool contains(const QString &name) const;
+    // -1 if not found
+    int indexOf(const QString &name) const;
+    const Entry &at(int index) const;
+    // nullptr if not found. don't change anything the order depends on
+    Entry *find(const QString &name);
+    // inserts after equal entries; returns the new index. name must not be present
+    int insert(const Entry &entry, const Compare &less);
+    // returns the former index, -1 if not found
+    int remove(const QString &name);
+
+private:
+    struct Node {
+        Entry entry;
+        int left, right, parent;
+        int size;
+        quint32 priority;
+    };
+    std::vector<Node> nodes;
+    std::vector<int> freeNodes;
+    QHash<QString, int> byName;
+    int root;
+    std::mt19937 random;
+
+    int sizeOf(int n) const;
+    void update(int n);
+    void setParent(int n, int parent);
+    int rankOf(int n) const;
+    int nodeAt(int index) const;
+    int newNode(const Entry &entry);
+    void split(int t, int k, int &l, int &r);
+    int merge(int a, int b);
+    int updateSizes(int n);
+};
@@ -1,17 +1,19 @@
 #include "directorywatcher_p.h"
 
 #include <QRegExp>
+#include <QFile>
+#include "settings.h"
 
 #ifdef __linux__
+#include <sys/vfs.h>
 #include "linux/linuxwatcher.h"
+#include "pollingwatcher.h"
 #elif _WIN32
 #include "windows/windowswatcher.h"
 #elif __unix__
-// TODO: implement this
-#include "dummywatcher.h"
+#include "pollingwatcher.h"
 #elif __APPLE__
-// TODO: implement this
-#include "dummywatcher.h"
+#include "pollingwatcher.h"
 #else
 // TODO: implement this
 #include "dummywatcher.h"
@@ -32,25 +34,61 @@ DirectoryWatcher::~DirectoryWatcher() {
 }
 
 // Move this function to some creational class
-DirectoryWatcher *DirectoryWatcher::newInstance()
+DirectoryWatcher *DirectoryWatcher::newInstance(bool polling)
 {
     DirectoryWatcher* watcher;
 
 #ifdef __linux__
-        watcher = new LinuxWatcher();
+        if (polling)
+            watcher = new PollingWatcher();
+        else
+            watcher = new LinuxWatcher();
 #elif _WIN32
+        Q_UNUSED(polling)
         watcher = new WindowsWatcher();
 #elif __unix__
-        watcher = new DummyWatcher();
+        Q_UNUSED(polling)
+        watcher = new PollingWatcher();
 #elif __APPLE__
-        watcher = new DummyWatcher();
+        Q_UNUSED(polling)
+        watcher = new PollingWatcher();
 #else
+        Q_UNUSED(polling)
         watcher = new DummyWatcher();
 #endif
 
     return watcher;
 }
 
+bool DirectoryWatcher::needsPolling(const QString& path)
+{
+    if (settings->forcePollingWatcher())
+        return true;
+#ifdef __linux__
+    struct statfs info;
+    if (statfs(QFile::encodeName(path).constData(), &info) != 0)
+        return false;
+    // inotify only sees changes made through this machine's kernel
+    switch (static_cast<quint32>(info.f_type)) {
+    case 0x6969:        // nfs
+    case 0x517B:        // smbfs
+    case 0xFF534D42:    // cifs
+    case 0xFE534D42:    // smb2
+    case 0x65735546:    // fuse (sshfs, rclone, ...)
+    case 0x01021997:    // 9p
+    case 0x00C36400:    // ceph
+    case 0x73757245:    // coda
+    case 0x5346414F:    // afs
+        return true;
+    default:
+        return false;
+    }
+#else
+    Q_UNUSED(path)
+    return false;
+#endif
+}
+
 void DirectoryWatcher::setWatchPath(const QString& path) {
     Q_D(DirectoryWatcher);
     d->currentDirectory = path;
@@ -7,7 +7,9 @@ class DirectoryWatcherPrivate;
 class DirectoryWatcher : public QObject {
     Q_OBJECT
 public:
-    static DirectoryWatcher* newInstance();
+    static DirectoryWatcher* newInstance(bool polling = false);
+    // True where the native watcher won't see changes, e.g. network mounts
+    static bool needsPolling(const QString& path);
 
     virtual ~DirectoryWatcher();
 
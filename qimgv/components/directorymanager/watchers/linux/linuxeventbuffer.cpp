@@ -0,0 +1,73 @@
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+#include "linuxeventbuffer.h"
+
+// header value for "rest of the buffer is unused, continue at the start"
+static const uint64_t WRAP_MARKER = ~uint64_t(0);
+
+LinuxEventBuffer::LinuxEventBuffer() :
+    data(CAPACITY),
+    head(0),
+    tail(0),
+    chunkSize(0)
+{
+}
+
+size_t LinuxEventBuffer::align(size_t size) {
+    return (size + HEADER_SIZE - 1) & ~(HEADER_SIZE - 1);
+}
+
+char *LinuxEventBuffer::writeSpace(size_t minSize, size_t &size) {
+    size_t h = head.load(std::memory_order_relaxed);
+    size_t t = tail.load(std::memory_order_acquire);
+    size_t offset = h % CAPACITY;
+    size_t contiguous = CAPACITY - offset;
+    // inotify won't split an event, so skip a tail end that is too short
+    if(contiguous < HEADER_SIZE + minSize) {
+        if(CAPACITY - (h - t) < contiguous)
+            return nullptr;
+        memcpy(&data[offset], &WRAP_MARKER, HEADER_SIZE);
+        h += contiguous;
+        head.store(h, std::memory_order_release);
+        offset = 0;
+        contiguous = CAPACITY;
+    }
+    size_t available = std::min(contiguous, CAPACITY - (h - t));
+    if(available < HEADER_SIZE + minSize)
+        return nullptr;
+    size = available - HEADER_SIZE;
+    return &data[offset + HEADER_SIZE];
+}
+
+void LinuxEventBuffer::commit(size_t size) {
+    size_t h = head.load(std::memory_order_relaxed);
+    uint64_t header = size;
+    memcpy(&data[h % CAPACITY], &header, HEADER_SIZE);
+    head.store(h + HEADER_SIZE + align(size), std::memory_order_release);
+}
+
+const char *LinuxEventBuffer::readChunk(size_t &size) {
+    for(;;) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if(t == head.load(std::memory_order_acquire))
+            return nullptr;
+        size_t offset = t % CAPACITY;
+        uint64_t header;
+        memcpy(&header, &data[offset], HEADER_SIZE);
+        if(header == WRAP_MARKER) {
+            tail.store(t + (CAPACITY - offset), std::memory_order_release);
+            continue;
+        }
+        size = static_cast<size_t>(header);
+        chunkSize = HEADER_SIZE + align(size);
+        return &data[offset + HEADER_SIZE];
+    }
+}
+
+void LinuxEventBuffer::release() {
+    size_t t = tail.load(std::memory_order_relaxed);
+    tail.store(t + chunkSize, std::memory_order_release);
+    chunkSize = 0;
+}
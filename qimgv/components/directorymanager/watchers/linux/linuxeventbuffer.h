@@ -0,0 +1,34 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+
+// Single producer / single consumer ring for raw inotify data.
+// The worker reads straight into free space and publishes whole reads,
+// the watcher takes them in the same order. No locks, no allocation after construction.
+class LinuxEventBuffer {
+public:
+    LinuxEventBuffer();
+
+    // producer: contiguous free space of at least minSize bytes, nullptr if full
+    char *writeSpace(size_t minSize, size_t &size);
+    // publishes the first `size` bytes of the last writeSpace()
+    void commit(size_t size);
+
+    // consumer: next published read, nullptr if there is none
+    const char *readChunk(size_t &size);
+    // hands the chunk from readChunk() back to the producer
+    void release();
+
+private:
+    static const size_t CAPACITY = 1 << 20;
+    static const size_t HEADER_SIZE = 8;
+    std::vector<char> data;
+    // running byte counters, not offsets
+    std::atomic<size_t> head, tail;
+    // consumer only
+    size_t chunkSize;
+
+    static size_t align(size_t size);
+};
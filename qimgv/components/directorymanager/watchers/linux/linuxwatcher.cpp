@@ -1,160 +1,289 @@
-#include <QTimer>
-
 #include <sys/inotify.h>
+#include <unistd.h>
 
 #include "linuxwatcher_p.h"
 #include "linuxworker.h"
 
 #define TAG                 "[LinuxDirectoryWatcher]"
-#define INOTIFY_EVENT_MASK  IN_CREATE | IN_MODIFY | IN_DELETE | IN_MOVE
+#define INOTIFY_EVENT_MASK  IN_CREATE | IN_MODIFY | IN_CLOSE_WRITE | IN_DELETE | IN_MOVE
 
 /**
   * Time to wait for rename event. If event take time longer
   * than specified then event will be considered as remove event
   */
-
-// TODO: this may break event order.
-// Implement a proper queue.
 #define EVENT_MOVE_TIMEOUT      150 // ms
-#define EVENT_MODIFY_TIMEOUT    150 // ms
+/**
+  * Files are reported when closed after writing. This is the fallback
+  * for writers that keep them open (mmap, logs)
+  */
+#define EVENT_WRITE_IDLE_TIMEOUT    1000 // ms
+
+#define WHEEL_SLOTS             32
+#define WHEEL_TICK              25 // ms
 
 LinuxWatcherPrivate::LinuxWatcherPrivate(LinuxWatcher* qq) :
     DirectoryWatcherPrivate(qq, new LinuxWorker()),
     watcher(-1),
-    watchObject(-1)
+    watchObject(-1),
+    firstId(0),
+    timerWheel(WHEEL_SLOTS),
+    wheelPos(0),
+    wheelTime(0)
 {
-    watcher = inotify_init();
+    watcher = inotify_init1(IN_CLOEXEC);
+    clock.start();
 }
 
-int LinuxWatcherPrivate::indexOfWatcherEvent(uint cookie) const {
-    for (int i = 0; i < watcherEvents.size(); ++i) {
-        auto event = watcherEvents.at(i);
-        if (event->cookie() == cookie) {
-            return i;
-        }
-    }
-    return -1;
-}
-
-int LinuxWatcherPrivate::indexOfWatcherEvent(const QString& name) const {
-    for (int i = 0; i < watcherEvents.size(); ++i) {
-        auto event = watcherEvents.at(i);
-        if (event->name() == name) {
-            return i;
-        }
-    }
-    return -1;
-}
+void LinuxWatcherPrivate::dispatchFilesystemEvents() {
+    auto linuxWorker = static_cast<LinuxWorker*>(worker.data());
+    LinuxEventBuffer *buffer = linuxWorker->buffer();
+
+    linuxWorker->beginRead();
+    size_t dataSize = 0;
+    while (const char *data = buffer->readChunk(dataSize)) {
+        size_t dataOffset = 0;
+        while (dataOffset < dataSize) {
+            auto notify_event = reinterpret_cast<const inotify_event*>(data + dataOffset);
+            dataOffset += sizeof(inotify_event) + notify_event->len;
+
+            uint mask = notify_event->mask;
+            if (mask & IN_Q_OVERFLOW) {
+                qDebug() << TAG << "Event queue overflow, some changes were missed";
+                continue;
+            }
+            // Leftovers from the previous directory, or the directory itself
+            if (notify_event->wd != watchObject || notify_event->len == 0) {
+                continue;
+            }
 
-void LinuxWatcherPrivate::dispatchFilesystemEvent(LinuxFsEvent* e) {
-    Q_Q(LinuxWatcher);
+            QString name    = notify_event->name;
+            uint cookie     = notify_event->cookie;
+            bool isDirEvent = mask & IN_ISDIR;
 
-    uint dataOffset = 0;
-    QScopedPointer<LinuxFsEvent> event(e);
-
-    while (dataOffset < event->dataSize()) {
-        inotify_event* notify_event = (inotify_event*) (event->data() + dataOffset);
-        dataOffset += sizeof(inotify_event) + notify_event->len;
-
-        int mask        = notify_event->mask;
-        QString name    = notify_event->name;
-        uint cookie     = notify_event->cookie;
-        bool isDirEvent = mask & IN_ISDIR;
-        
-        // Skip events for directories and files that isn't in filter range
-        if ( (isDirEvent) && !(mask & IN_MOVED_TO) ) {
-            continue;
-        }
+            // Skip events for directories and files that isn't in filter range
+            if ( (isDirEvent) && !(mask & IN_MOVED_TO) ) {
+                continue;
+            }
 
-        if (mask & IN_MODIFY) {
-            handleModifyEvent(name);
-        } else if (mask & IN_CREATE) {
-            handleCreateEvent(name);
-        } else if (mask & IN_DELETE) {
-            handleDeleteEvent(name);
-        } else if (mask & IN_MOVED_FROM) {
-            handleMovedFromEvent(name, cookie);
-        } else if (mask & IN_MOVED_TO) {
-            handleMovedToEvent(name, cookie);
+            if (mask & IN_MODIFY) {
+                handleModifyEvent(name);
+            } else if (mask & IN_CLOSE_WRITE) {
+                handleCloseWriteEvent(name);
+            } else if (mask & IN_CREATE) {
+                handleCreateEvent(name);
+            } else if (mask & IN_DELETE) {
+                handleDeleteEvent(name);
+            } else if (mask & IN_MOVED_FROM) {
+                handleMovedFromEvent(name, cookie);
+            } else if (mask & IN_MOVED_TO) {
+                handleMovedToEvent(name, cookie);
+            }
         }
+        buffer->release();
     }
+    linuxWorker->endRead();
+    emitReadyEvents();
 }
 
 void LinuxWatcherPrivate::handleModifyEvent(const QString &name) {
-    // Find the same event in the list by file name
-    int eventIndex = indexOfWatcherEvent(name);
-    if (eventIndex == -1) {
-        // This is this first modify event for the current file
-        int timerId = startTimer(EVENT_MODIFY_TIMEOUT);
-        auto event = new WatcherEvent(name, timerId, WatcherEvent::Modify);
-        watcherEvents.append(QSharedPointer<WatcherEvent>(event));
-    } else {
-        auto event = watcherEvents.at(eventIndex);
-        // Restart timer again
-        killTimer(event->timerId());
-        int timerId = startTimer(EVENT_MODIFY_TIMEOUT);
-        event->setTimerId(timerId);
+    qint64 deadline = clock.elapsed() + EVENT_WRITE_IDLE_TIMEOUT;
+    auto it = openWrites.find(name);
+    if (it != openWrites.end()) {
+        // Rescheduled lazily when the old deadline comes up
+        it->deadline = deadline;
+        return;
     }
+    openWrites.insert(name, { false, deadline });
+    schedule({ 0, name }, deadline);
+}
+
+void LinuxWatcherPrivate::handleCloseWriteEvent(const QString &name) {
+    // Closing without writing anything changes nothing
+    if (openWrites.contains(name))
+        finishWrite(name);
 }
 
 void LinuxWatcherPrivate::handleDeleteEvent(const QString &name) {
-    Q_Q(LinuxWatcher);
-    emit q->fileDeleted(name);
+    auto it = openWrites.find(name);
+    if (it != openWrites.end()) {
+        bool created = it->created;
+        openWrites.erase(it);
+        // A temporary file nobody was told about
+        if (created)
+            return;
+    }
+    appendEvent(PendingEvent::Deleted, name, true);
 }
 
+// New files are announced once they are complete, see finishWrite()
 void LinuxWatcherPrivate::handleCreateEvent(const QString &name) {
-    Q_Q(LinuxWatcher);
-    emit q->fileCreated(name);
+    qint64 deadline = clock.elapsed() + EVENT_WRITE_IDLE_TIMEOUT;
+    openWrites.insert(name, { true, deadline });
+    schedule({ 0, name }, deadline);
 }
 
 void LinuxWatcherPrivate::handleMovedFromEvent(const QString &name, uint cookie) {
-    int timerId = startTimer(EVENT_MOVE_TIMEOUT);
-    // Save timer id to find out later which event timer is running
-    auto event = new WatcherEvent(name, cookie, timerId, WatcherEvent::MovedFrom);
-    watcherEvents.append(QSharedPointer<WatcherEvent>(event));
+    // "file.part" -> "file.jpg" only announces the final name
+    bool announced = !openWrites.value(name, { false, 0 }).created;
+    openWrites.remove(name);
+    qint64 deadline = clock.elapsed() + EVENT_MOVE_TIMEOUT;
+    quint64 id = appendEvent(PendingEvent::MovedFrom, name, false);
+    pendingEvents.back().cookie = cookie;
+    pendingEvents.back().announced = announced;
+    pendingEvents.back().deadline = deadline;
+    movesByCookie.insert(cookie, id);
+    schedule({ id, QString() }, deadline);
 }
 
+// A file moved in is complete by definition
 void LinuxWatcherPrivate::handleMovedToEvent(const QString &name, uint cookie) {
-    Q_Q(LinuxWatcher);
-
+    openWrites.remove(name);
     // Check if file waiting to be renamed
-    int eventIndex = indexOfWatcherEvent(cookie);
-    if (eventIndex == -1) {
-        // No one event waiting for rename so this is a new file
-        emit q->fileCreated(name);
+    PendingEvent *event = nullptr;
+    auto it = movesByCookie.find(cookie);
+    if (it != movesByCookie.end()) {
+        event = findEvent(it.value());
+        movesByCookie.erase(it);
+    }
+    if (event && event->type == PendingEvent::MovedFrom && !event->ready) {
+        // Keeps the position of the first half
+        if (event->announced) {
+            event->type = PendingEvent::Renamed;
+            event->newName = name;
+        } else {
+            event->type = PendingEvent::Created;
+            event->name = name;
+        }
+        event->ready = true;
     } else {
-        // Waiting for rename event is found
-        auto watcherEvent = watcherEvents.takeAt(eventIndex);
-        // Kill associated timer
-        killTimer(watcherEvent->timerId());
-        emit q->fileRenamed(watcherEvent->name(), name);
+        // No one event waiting for rename so this is a new file
+        appendEvent(PendingEvent::Created, name, true);
     }
 }
 
-void LinuxWatcherPrivate::timerEvent(QTimerEvent *timerEvent) {
-    Q_Q(LinuxWatcher);
+void LinuxWatcherPrivate::finishWrite(const QString &name) {
+    auto it = openWrites.find(name);
+    if (it == openWrites.end())
+        return;
+    bool created = it->created;
+    openWrites.erase(it);
+    appendEvent(created ? PendingEvent::Created : PendingEvent::Modified, name, true);
+}
 
-    // Loop through waiting move events
-    int lastIndex = watcherEvents.size() - 1;
-    for (int i = lastIndex; i >= 0; --i) {
-        auto watcherEvent = watcherEvents.at(i);
-
-        if (watcherEvent->timerId() == timerEvent->timerId()) {
-            int type = watcherEvent->type();
-            if (type == WatcherEvent::MovedFrom) {
-                // Rename event didn't happen so treat this event as remove event
-                emit q->fileDeleted(watcherEvent->name());
-            } else if (type == WatcherEvent::Modify) {
-                emit q->fileModified(watcherEvent->name());
-            }
+void LinuxWatcherPrivate::clearPendingEvents() {
+    firstId += pendingEvents.size();
+    pendingEvents.clear();
+    movesByCookie.clear();
+    openWrites.clear();
+    for (auto &slot : timerWheel)
+        slot.clear();
+    wheelTimer.stop();
+}
+
+LinuxWatcherPrivate::PendingEvent *LinuxWatcherPrivate::findEvent(quint64 id) {
+    if (id < firstId || id - firstId >= pendingEvents.size())
+        return nullptr;
+    return &pendingEvents[id - firstId];
+}
+
+quint64 LinuxWatcherPrivate::appendEvent(PendingEvent::Type type, const QString &name, bool ready) {
+    PendingEvent event;
+    event.type = type;
+    event.name = name;
+    event.cookie = 0;
+    event.ready = ready;
+    event.announced = true;
+    event.deadline = 0;
+    pendingEvents.push_back(event);
+    return firstId + pendingEvents.size() - 1;
+}
+
+void LinuxWatcherPrivate::schedule(const WheelItem &item, qint64 deadline) {
+    if (!wheelTimer.isActive()) {
+        wheelTime = clock.elapsed() + WHEEL_TICK;
+        wheelTimer.start(WHEEL_TICK, this);
+    }
+    // Deadlines past the last slot get rescheduled when their slot comes up
+    qint64 ticks = (deadline - wheelTime + WHEEL_TICK - 1) / WHEEL_TICK;
+    ticks = qBound<qint64>(0, ticks, WHEEL_SLOTS - 1);
+    timerWheel[(wheelPos + ticks) % WHEEL_SLOTS].push_back(item);
+}
+
+void LinuxWatcherPrivate::expire(quint64 id, PendingEvent &event) {
+    if (event.type == PendingEvent::MovedFrom) {
+        // Rename event didn't happen so treat this event as remove event
+        auto it = movesByCookie.find(event.cookie);
+        if (it != movesByCookie.end() && it.value() == id)
+            movesByCookie.erase(it);
+        event.type = event.announced ? PendingEvent::Deleted : PendingEvent::Dropped;
+    }
+    event.ready = true;
+}
 
-            watcherEvents.removeAt(i);
+void LinuxWatcherPrivate::emitReadyEvents() {
+    Q_Q(LinuxWatcher);
+
+    while (!pendingEvents.empty() && pendingEvents.front().ready) {
+        PendingEvent event = pendingEvents.front();
+        pendingEvents.pop_front();
+        firstId++;
+        switch (event.type) {
+        case PendingEvent::Created:
+            emit q->fileCreated(event.name);
+            break;
+        case PendingEvent::Deleted:
+            emit q->fileDeleted(event.name);
+            break;
+        case PendingEvent::Modified:
+            emit q->fileModified(event.name);
+            break;
+        case PendingEvent::Renamed:
+            emit q->fileRenamed(event.name, event.newName);
+            break;
+        default:
             break;
         }
     }
+    if (pendingEvents.empty() && openWrites.isEmpty() && wheelTimer.isActive()) {
+        for (auto &slot : timerWheel)
+            slot.clear();
+        wheelTimer.stop();
+    }
+}
 
-    // Stop timer anyway
-    killTimer(timerEvent->timerId());
+void LinuxWatcherPrivate::timerEvent(QTimerEvent *timerEvent) {
+    if (timerEvent->timerId() != wheelTimer.timerId()) {
+        DirectoryWatcherPrivate::timerEvent(timerEvent);
+        return;
+    }
+    qint64 now = clock.elapsed();
+    while (wheelTime <= now) {
+        // rescheduling never lands in the current slot
+        std::vector<WheelItem> &slot = timerWheel[wheelPos];
+        for (const WheelItem &item : slot) {
+            if (!item.fileName.isEmpty()) {
+                auto it = openWrites.constFind(item.fileName);
+                if (it == openWrites.constEnd())
+                    continue;
+                if (it->deadline > now)
+                    schedule(item, it->deadline);
+                else
+                    finishWrite(item.fileName);
+                continue;
+            }
+            PendingEvent *event = findEvent(item.id);
+            if (!event || event->ready)
+                continue;
+            if (event->deadline > now)
+                schedule(item, event->deadline);
+            else
+                expire(item.id, *event);
+        }
+        slot.clear();
+        wheelPos = (wheelPos + 1) % WHEEL_SLOTS;
+        wheelTime += WHEEL_TICK;
+    }
+    emitReadyEvents();
 }
 
 LinuxWatcher::LinuxWatcher() : DirectoryWatcher(new LinuxWatcherPrivate(this)) {
@@ -166,8 +295,8 @@ LinuxWatcher::LinuxWatcher() : DirectoryWatcher(new LinuxWatcherPrivate(this)) {
     auto linuxWorker = static_cast<LinuxWorker*>(d->worker.data());
     linuxWorker->setDescriptor(d->watcher);
 
-    connect(linuxWorker, &LinuxWorker::fileEvent,
-            d, &LinuxWatcherPrivate::dispatchFilesystemEvent);
+    connect(linuxWorker, &LinuxWorker::eventsAvailable,
+            d, &LinuxWatcherPrivate::dispatchFilesystemEvents);
 
     // Here's no need to destroy thread and worker. They're will be removed automatically
     connect(linuxWorker, &LinuxWorker::finished, d->workerThread.data(), &QThread::quit);
@@ -178,10 +307,18 @@ LinuxWatcher::LinuxWatcher() : DirectoryWatcher(new LinuxWatcherPrivate(this)) {
 
 LinuxWatcher::~LinuxWatcher() {
     Q_D(LinuxWatcher);
-    int removeStatusCode = inotify_rm_watch(d->watcher, d->watchObject);
-    if (removeStatusCode != 0) {
-        qDebug() << TAG << "Cannot remove inotify watcher instance:" << strerror(errno);
+    // The worker sleeps in poll() until woken up
+    d->worker->setRunning(false);
+    d->workerThread->quit();
+    d->workerThread->wait();
+    if (d->watchObject != -1) {
+        int removeStatusCode = inotify_rm_watch(d->watcher, d->watchObject);
+        if (removeStatusCode != 0) {
+            qDebug() << TAG << "Cannot remove inotify watcher instance:" << strerror(errno);
+        }
     }
+    if (d->watcher != -1)
+        close(d->watcher);
 }
 
 void LinuxWatcher::setWatchPath(const QString& path) {
@@ -195,6 +332,8 @@ void LinuxWatcher::setWatchPath(const QString& path) {
             qDebug() << TAG << "Error:" << strerror(errno);
         }
     }
+    // Anything still waiting belongs to the previous directory
+    d->clearPendingEvents();
 
     // Add new path to be watched by inotify
     d->watchObject = inotify_add_watch(d->watcher, path.toStdString().data(), INOTIFY_EVENT_MASK);
@@ -5,37 +5,89 @@
 #include "../directorywatcher_p.h"
 
 #include <errno.h>
+#include <deque>
+#include <vector>
 #include <QDebug>
-#include <QTimer>
-
-class LinuxFsEvent;
+#include <QHash>
+#include <QBasicTimer>
+#include <QElapsedTimer>
 
 class LinuxWatcherPrivate : public DirectoryWatcherPrivate {
     Q_OBJECT
 public:
     explicit LinuxWatcherPrivate(LinuxWatcher* qq = 0);
 
-    int indexOfWatcherEvent(uint cookie) const;
-    int indexOfWatcherEvent(const QString& name) const;
-
     void handleModifyEvent(const QString& name);
+    void handleCloseWriteEvent(const QString& name);
     void handleDeleteEvent(const QString& name);
     void handleCreateEvent(const QString& name);
     void handleMovedFromEvent(const QString& name, uint cookie);
     void handleMovedToEvent(const QString& name, uint cookie);
+    // drops events that weren't sent yet
+    void clearPendingEvents();
 
     int watcher;
     int watchObject;
 
-    QVector<QSharedPointer<WatcherEvent>> watcherEvents;
-
 protected:
     virtual void timerEvent(QTimerEvent* timerEvent) override;
 
 private slots:
-    void dispatchFilesystemEvent(LinuxFsEvent *e);
+    void dispatchFilesystemEvents();
 
 private:
+    // Events go out strictly in the order they came in. A move that is
+    // still waiting for its other half holds back everything after it.
+    struct PendingEvent {
+        enum Type {
+            Created,
+            Deleted,
+            Modified,
+            MovedFrom,
+            Renamed,
+            // moved away before anyone heard of it
+            Dropped
+        };
+        Type type;
+        QString name;
+        QString newName;
+        uint cookie;
+        bool ready;
+        // false for a file moved away while it was still being written
+        bool announced;
+        qint64 deadline;
+    };
+    std::deque<PendingEvent> pendingEvents;
+    // id of the first pending event; every event gets the next id
+    quint64 firstId;
+    QHash<uint, quint64> movesByCookie;
+
+    // Files that are open for writing. They are reported once closed,
+    // or after a while without writes for writers that never close.
+    struct OpenWrite {
+        bool created;
+        qint64 deadline;
+    };
+    QHash<QString, OpenWrite> openWrites;
+
+    // one timer for all deadlines; an item is either an event id or a file being written
+    struct WheelItem {
+        quint64 id;
+        QString fileName;
+    };
+    std::vector<std::vector<WheelItem>> timerWheel;
+    int wheelPos;
+    qint64 wheelTime;
+    QBasicTimer wheelTimer;
+    QElapsedTimer clock;
+
+    PendingEvent *findEvent(quint64 id);
+    quint64 appendEvent(PendingEvent::Type type, const QString &name, bool ready);
+    void schedule(const WheelItem &item, qint64 deadline);
+    void expire(quint64 id, PendingEvent &event);
+    void finishWrite(const QString &name);
+    void emitReadyEvents();
+
     Q_DECLARE_PUBLIC(LinuxWatcher)
 };
 
@@ -1,6 +1,11 @@
 #include <sys/poll.h>
-#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 #include <unistd.h>
+#include <limits.h>
+#include <stdint.h>
+#include <errno.h>
+#include <string.h>
 
 #include <QThread>
 #include <QDebug>
@@ -8,51 +13,100 @@
 #include "linuxworker.h"
 
 #define TAG         "[LinuxWatcherWorker]"
-#define TIMEOUT     300 // ms
+// smallest read that fits any single event
+#define READ_MIN_SIZE   (sizeof(inotify_event) + NAME_MAX + 1)
 
 LinuxWorker::LinuxWorker() :
-    fd(-1)
+    fd(-1),
+    notified(false),
+    bufferFull(false)
 {
+    wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    handleErrorCode(wakeFd);
+}
+
+LinuxWorker::~LinuxWorker() {
+    if (wakeFd != -1)
+        close(wakeFd);
 }
 
 void LinuxWorker::setDescriptor(int desc) {
     fd = desc;
 }
 
+void LinuxWorker::setRunning(bool running) {
+    WatcherWorker::setRunning(running);
+    if (!running)
+        wake();
+}
+
+LinuxEventBuffer *LinuxWorker::buffer() {
+    return &eventBuffer;
+}
+
+void LinuxWorker::beginRead() {
+    notified.store(false);
+}
+
+void LinuxWorker::endRead() {
+    if (bufferFull.exchange(false))
+        wake();
+}
+
+void LinuxWorker::wake() {
+    uint64_t value = 1;
+    if (wakeFd != -1 && write(wakeFd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+        handleErrorCode(-1);
+}
+
 void LinuxWorker::run() {
     emit started();
-    isRunning.store(true);
 
-    if (fd == -1) {
+    if (fd == -1 || wakeFd == -1) {
         qDebug() << TAG << "File descriptor isn't set! Stopping";
         emit finished();
         return;
     }
 
+    pollfd pollDescriptors[2] = { { fd, POLLIN, 0 }, { wakeFd, POLLIN, 0 } };
     while (isRunning) {
-        int errorCode = 0;
-        uint bytesAvailable = 0;
-
-        // File descriptor event struct for polling service
-        pollfd pollDescriptor = { fd, POLLIN, 0 };
-
-        // Freeze thread till next event
-        errorCode = poll(&pollDescriptor, 1, TIMEOUT);
-        handleErrorCode(errorCode);
-
-        // Check how many bytes available
-        errorCode = ioctl(fd, FIONREAD, &bytesAvailable);
-        handleErrorCode(errorCode);
+        size_t size = 0;
+        char *space = eventBuffer.writeSpace(READ_MIN_SIZE, size);
+        if (!space) {
+            // watcher is behind; the kernel keeps queueing meanwhile.
+            // check again after setting the flag, the watcher may have just finished
+            bufferFull.store(true);
+            space = eventBuffer.writeSpace(READ_MIN_SIZE, size);
+        }
+        pollDescriptors[0].events = space ? POLLIN : 0;
+
+        // Freeze thread till next event or wakeup
+        int errorCode = poll(pollDescriptors, 2, -1);
+        if (errorCode == -1) {
+            if (errno == EINTR)
+                continue;
+            handleErrorCode(errorCode);
+            break;
+        }
 
-        if (bytesAvailable == 0) {
+        if (pollDescriptors[1].revents & POLLIN) {
+            uint64_t value;
+            if (read(wakeFd, &value, sizeof(value)) == -1 && errno != EAGAIN)
+                handleErrorCode(-1);
             continue;
         }
 
-        char* eventData = new char[bytesAvailable];
-        errorCode = read(fd, eventData, bytesAvailable);
-        handleErrorCode(errorCode);
-
-        emit fileEvent(new LinuxFsEvent(eventData, bytesAvailable));
+        if (!space || !(pollDescriptors[0].revents & POLLIN))
+            continue;
+        ssize_t bytesRead = read(fd, space, size);
+        if (bytesRead <= 0) {
+            if (bytesRead == -1 && errno != EINTR && errno != EAGAIN)
+                handleErrorCode(-1);
+            continue;
+        }
+        eventBuffer.commit(static_cast<size_t>(bytesRead));
+        if (!notified.exchange(true))
+            emit eventsAvailable();
     }
 
     emit finished();
@@ -1,6 +1,7 @@
 #pragma once
 
-#include "linuxfsevent.h"
+#include <atomic>
+#include "linuxeventbuffer.h"
 #include "../watcherworker.h"
 
 class LinuxWorker : public WatcherWorker
@@ -8,15 +9,30 @@ class LinuxWorker : public WatcherWorker
     Q_OBJECT
 public:
     LinuxWorker();
+    ~LinuxWorker();
 
     void setDescriptor(int desc);
     void handleErrorCode(int code);
 
     virtual void run() override;
+    virtual void setRunning(bool running) override;
+
+    // consumer side, for the watcher's thread
+    LinuxEventBuffer *buffer();
+    // call before draining the buffer, so that new data gets signaled again
+    void beginRead();
+    // call after draining; resumes reading if the buffer was full
+    void endRead();
 
 signals:
-    void fileEvent(LinuxFsEvent* event);
+    // once per batch of reads, not per read
+    void eventsAvailable();
 
 private:
     int fd;
+    // wakes up poll() for stop requests & freed buffer space
+    int wakeFd;
+    LinuxEventBuffer eventBuffer;
+    std::atomic_bool notified, bufferFull;
+    void wake();
 };
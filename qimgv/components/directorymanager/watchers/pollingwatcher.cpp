@@ -0,0 +1,41 @@
+#include "pollingwatcher.h"
+#include "pollingworker.h"
+#include "directorywatcher_p.h"
+
+class PollingWatcherPrivate : public DirectoryWatcherPrivate {
+  public:
+    PollingWatcherPrivate(PollingWatcher* watcher) : DirectoryWatcherPrivate(watcher, new PollingWorker()) {}
+};
+
+PollingWatcher::PollingWatcher() : DirectoryWatcher(new PollingWatcherPrivate(this)) {
+    Q_D(PollingWatcher);
+
+    connect(d->workerThread.data(), &QThread::started, d->worker.data(), &WatcherWorker::run);
+    d->worker.data()->moveToThread(d->workerThread.data());
+
+    auto pollingWorker = static_cast<PollingWorker*>(d->worker.data());
+    // Worker already sends settled changes, pass them as they are
+    connect(pollingWorker, &PollingWorker::fileCreated, this, &PollingWatcher::fileCreated);
+    connect(pollingWorker, &PollingWorker::fileDeleted, this, &PollingWatcher::fileDeleted);
+    connect(pollingWorker, &PollingWorker::fileRenamed, this, &PollingWatcher::fileRenamed);
+    connect(pollingWorker, &PollingWorker::fileModified, this, &PollingWatcher::fileModified);
+
+    connect(pollingWorker, &PollingWorker::finished, d->workerThread.data(), &QThread::quit);
+
+    connect(pollingWorker, &PollingWorker::started, this, &PollingWatcher::observingStarted);
+    connect(pollingWorker, &PollingWorker::finished, this, &PollingWatcher::observingStopped);
+}
+
+PollingWatcher::~PollingWatcher() {
+    Q_D(PollingWatcher);
+    // The worker sleeps between scans until woken up
+    d->worker->setRunning(false);
+    d->workerThread->quit();
+    d->workerThread->wait();
+}
+
+void PollingWatcher::setWatchPath(const QString& path) {
+    Q_D(PollingWatcher);
+    DirectoryWatcher::setWatchPath(path);
+    static_cast<PollingWorker*>(d->worker.data())->setPath(path);
+}
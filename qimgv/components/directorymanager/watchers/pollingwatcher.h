@@ -0,0 +1,16 @@
+#pragma once
+
+#include "directorywatcher.h"
+
+class PollingWatcherPrivate;
+
+class PollingWatcher : public DirectoryWatcher {
+    Q_OBJECT
+public:
+    explicit PollingWatcher();
+    virtual ~PollingWatcher();
+    virtual void setWatchPath(const QString& path);
+
+private:
+    Q_DECLARE_PRIVATE(PollingWatcher)
+};
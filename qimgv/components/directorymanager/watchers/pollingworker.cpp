@@ -0,0 +1,172 @@
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string.h>
+#include <errno.h>
+
+#include <QFile>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include "pollingworker.h"
+
+#define TAG             "[PollingWorker]"
+#define MIN_INTERVAL    500 // ms
+#define MAX_INTERVAL    8000 // ms
+// waits at least this many times the scan duration, big remote dirs are slow to list
+#define SCAN_COST_FACTOR    4
+
+PollingWorker::PollingWorker() :
+    pathGeneration(0)
+{
+}
+
+void PollingWorker::setPath(const QString &newPath) {
+    QMutexLocker locker(&mutex);
+    path = newPath;
+    pathGeneration++;
+    wakeUp.wakeAll();
+}
+
+void PollingWorker::setRunning(bool running) {
+    QMutexLocker locker(&mutex);
+    WatcherWorker::setRunning(running);
+    wakeUp.wakeAll();
+}
+
+void PollingWorker::run() {
+    emit started();
+
+    Snapshot snapshot;
+    // files that changed since the last poll; reported once they stop changing.
+    // true for files which are new
+    QHash<QByteArray, bool> unsettled;
+    quint64 snapshotGeneration = 0;
+    bool haveSnapshot = false;
+    int interval = MIN_INTERVAL;
+    QElapsedTimer timer;
+
+    while (isRunning) {
+        QByteArray dirPath;
+        quint64 generation;
+        {
+            QMutexLocker locker(&mutex);
+            dirPath = QFile::encodeName(path);
+            generation = pathGeneration;
+        }
+
+        timer.start();
+        Snapshot current;
+        bool ok = !dirPath.isEmpty() && scan(dirPath, current);
+        qint64 scanTime = timer.elapsed();
+
+        if (ok && (!haveSnapshot || generation != snapshotGeneration)) {
+            // new directory, nothing to compare with
+            snapshot.swap(current);
+            unsettled.clear();
+            snapshotGeneration = generation;
+            haveSnapshot = true;
+            interval = MIN_INTERVAL;
+        } else if (ok) {
+            bool changed = diff(snapshot, current, unsettled);
+            snapshot.swap(current);
+            // back off while nothing happens
+            if (changed || !unsettled.isEmpty())
+                interval = MIN_INTERVAL;
+            else
+                interval = qMin(interval * 2, MAX_INTERVAL);
+        }
+
+        QMutexLocker locker(&mutex);
+        if (isRunning && generation == pathGeneration)
+            wakeUp.wait(&mutex, static_cast<unsigned long>(qMax<qint64>(interval, scanTime * SCAN_COST_FACTOR)));
+    }
+
+    emit finished();
+}
+
+bool PollingWorker::scan(const QByteArray &dirPath, Snapshot &snapshot) {
+    DIR *dir = opendir(dirPath.constData());
+    if (!dir) {
+        qDebug() << TAG << "Cannot read" << dirPath << strerror(errno);
+        return false;
+    }
+    int dirFd = dirfd(dir);
+    while (dirent *entry = readdir(dir)) {
+        if (entry->d_type == DT_DIR)
+            continue;
+        struct stat info;
+        if (fstatat(dirFd, entry->d_name, &info, 0) != 0 || !S_ISREG(info.st_mode))
+            continue;
+        FileState state;
+        state.size = static_cast<qint64>(info.st_size);
+#ifdef __APPLE__
+        state.modifyTime = static_cast<qint64>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+        state.modifyTime = static_cast<qint64>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+        state.inode = static_cast<quint64>(info.st_ino);
+        snapshot.insert(QByteArray(entry->d_name), state);
+    }
+    closedir(dir);
+    return true;
+}
+
+// Returns true if anything changed.
+bool PollingWorker::diff(const Snapshot &before, const Snapshot &after, QHash<QByteArray, bool> &unsettled) {
+    bool changed = false;
+    // gone files by inode, so that renames can be paired up
+    QHash<quint64, QByteArray> removed;
+    for (auto i = before.constBegin(); i != before.constEnd(); ++i) {
+        if (!after.contains(i.key()))
+            removed.insert(i.value().inode, i.key());
+    }
+
+    for (auto i = after.constBegin(); i != after.constEnd(); ++i) {
+        auto old = before.constFind(i.key());
+        if (old == before.constEnd()) {
+            changed = true;
+            auto from = removed.find(i.value().inode);
+            if (from != removed.end() && before.value(from.value()).size == i.value().size) {
+                // Unsettled state moves along; "file.part" -> "file.jpg" is still a new file
+                bool isNew = false;
+                auto pending = unsettled.find(from.value());
+                if (pending != unsettled.end()) {
+                    isNew = pending.value();
+                    unsettled.erase(pending);
+                    unsettled.insert(i.key(), isNew);
+                }
+                if (!isNew)
+                    emit fileRenamed(QFile::decodeName(from.value()), QFile::decodeName(i.key()));
+                removed.erase(from);
+            } else {
+                unsettled.insert(i.key(), true);
+            }
+        } else if (!(old.value() == i.value())) {
+            changed = true;
+            if (!unsettled.contains(i.key()))
+                unsettled.insert(i.key(), false);
+        } else {
+            // same as the last time, so it's done being written
+            auto pending = unsettled.find(i.key());
+            if (pending != unsettled.end()) {
+                if (pending.value())
+                    emit fileCreated(QFile::decodeName(i.key()));
+                else
+                    emit fileModified(QFile::decodeName(i.key()));
+                unsettled.erase(pending);
+            }
+        }
+    }
+
+    for (auto i = removed.constBegin(); i != removed.constEnd(); ++i) {
+        changed = true;
+        // nobody heard of it if it was still new
+        bool isNew = unsettled.value(i.value(), false);
+        unsettled.remove(i.value());
+        if (!isNew)
+            emit fileDeleted(QFile::decodeName(i.value()));
+    }
+    return changed;
+}
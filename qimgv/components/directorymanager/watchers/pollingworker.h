@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include "watcherworker.h"
+
+// Compares directory snapshots every now and then.
+// For filesystems which don't report (remote) changes.
+class PollingWorker : public WatcherWorker
+{
+    Q_OBJECT
+public:
+    PollingWorker();
+
+    void setPath(const QString &path);
+
+    virtual void run() override;
+    virtual void setRunning(bool running) override;
+
+signals:
+    void fileCreated(const QString &fileName);
+    void fileDeleted(const QString &fileName);
+    void fileRenamed(const QString &oldName, const QString &newName);
+    void fileModified(const QString &fileName);
+
+private:
+    struct FileState {
+        qint64 size;
+        qint64 modifyTime;
+        quint64 inode;
+        bool operator==(const FileState &other) const {
+            return size == other.size && modifyTime == other.modifyTime && inode == other.inode;
+        }
+    };
+    using Snapshot = QHash<QByteArray, FileState>;
+
+    QMutex mutex;
+    QWaitCondition wakeUp;
+    QString path;
+    // bumped on every setPath()
+    quint64 pathGeneration;
+
+    static bool scan(const QByteArray &dirPath, Snapshot &snapshot);
+    bool diff(const Snapshot &before, const Snapshot &after, QHash<QByteArray, bool> &unsettled);
+};
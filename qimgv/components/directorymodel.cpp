@@ -1,13 +1,17 @@
 #include "directorymodel.h"
 
-DirectoryModel::DirectoryModel(QObject *parent) : QObject(parent) {
-    thumbnailer = new Thumbnailer(&dirManager);
+DirectoryModel::DirectoryModel(QObject *parent)
+    : QObject(parent),
+      randomizer(nullptr),
+      navInterval(FAST_NAVIGATION_INTERVAL * 4),
+      navForward(true)
+{
+    thumbnailer = new Thumbnailer(&dirManager, &loader);
     scaler = new Scaler(&cache);
 
     connect(&dirManager, &DirectoryManager::fileRemoved, this, &DirectoryModel::onFileRemoved);
     connect(&dirManager, &DirectoryManager::fileAdded, this, &DirectoryModel::onFileAdded);
-    connect(&dirManager, &DirectoryManager::fileModified,this, &DirectoryModel::onFileModified);
-    connect(&dirManager, &DirectoryManager::fileRenamed, this, &DirectoryModel::onFileRenamed);
+    connect(&dirManager, &DirectoryManager::filesChanged, this, &DirectoryModel::onFilesChanged);
     connect(&dirManager, &DirectoryManager::loaded, this, &DirectoryModel::loaded);
     connect(&dirManager, &DirectoryManager::sortingChanged, this, &DirectoryModel::onSortingChanged);
     connect(&loader, &Loader::loadFinished, this, &DirectoryModel::onItemReady);
@@ -209,10 +213,11 @@ bool DirectoryModel::setIndex(int index) {
 
     int oldIndex = currentIndex();
     QString newName = fileNameAt(index);
+    thumbnailer->deferBackgroundWork();
     if(mCurrentFileName != newName) {
         mCurrentFileName = fileNameAt(index);
+        updateNavigation(oldIndex, index);
         emit indexChanged(oldIndex, index);
-        trimCache();
     }
 
     cache.remove(mCurrentFileName);
@@ -220,12 +225,10 @@ bool DirectoryModel::setIndex(int index) {
     mCurrentFileName = newName;
     auto img = loader.load(fullPath(mCurrentFileName));
     cache.insert(img);
+    trimCache();
 
     emit itemReady(cache.get(mCurrentFileName));
-    if(settings->usePreloader()) {
-        preload(dirManager.prevOf(mCurrentFileName));
-        preload(dirManager.nextOf(mCurrentFileName));
-    }
+    preloadAround();
     return true;
 }
 
@@ -234,33 +237,30 @@ bool DirectoryModel::setIndexAsync(int index) {
         return false;
     QString newName = fileNameAt(index);
     int oldIndex = currentIndex();
+    thumbnailer->deferBackgroundWork();
     if(mCurrentFileName != newName) {
         mCurrentFileName = fileNameAt(index);
+        updateNavigation(oldIndex, index);
         emit indexChanged(oldIndex, index);
         trimCache();
     }
-    if(cache.contains(mCurrentFileName)) {
-        emit itemReady(cache.get(mCurrentFileName));
-        if(settings->usePreloader()) {
-            preload(dirManager.prevOf(mCurrentFileName));
-            preload(dirManager.nextOf(mCurrentFileName));
-        }
+    auto img = cache.get(mCurrentFileName);
+    if(img) {
+        emit itemReady(img);
     } else {
         loader.loadAsyncPriority(fullPath(mCurrentFileName));
     }
+    // queue the neighbours right away so we stay ahead when the user holds a key
+    preloadAround();
     return true;
 }
 
+// the old image stays on screen until the new one is decoded, see onItemReady()
 void DirectoryModel::reload(QString fileName) {
     if(!contains(fileName))
         return;
     cache.remove(fileName);
-    if(dirManager.contains(fileName)) {
-        auto img = loader.load(fullPath(mCurrentFileName));
-        cache.insert(img);
-        if(fileName == mCurrentFileName)
-            emit itemReady(img);
-    }
+    loader.reloadAsync(fullPath(fileName));
 }
 
 void DirectoryModel::unload(int index) {
@@ -282,40 +282,42 @@ std::shared_ptr<Image> DirectoryModel::itemAt(int index) {
     return cache.get(dirManager.fileNameAt(index));
 }
 
+// evicts least recently used images when over the memory budget
+// current image and its neighbours always stay
 void DirectoryModel::trimCache() {
-    QList<QString> list;
+    QList<QString> list = preloadList();
     list << prevOf(mCurrentFileName);
     list << mCurrentFileName;
     list << nextOf(mCurrentFileName);
-    cache.trimTo(list);
+    cache.setMaxSize(static_cast<qint64>(settings->imageCacheSize()) * 1024 * 1024);
+    cache.trim(list);
 }
 
 void DirectoryModel::onItemReady(std::shared_ptr<Image> img) {
     if(!img)
         return;
-    bool isRelevant = (img->name() == mCurrentFileName)
-                   || (img->name() == prevOf(mCurrentFileName))
-                   || (img->name() == nextOf(mCurrentFileName));
-    if(isRelevant) {
+    auto cached = cache.get(img->name());
+    bool upgrade = cached && cached->isReduced() && !img->isReduced();
+    if(contains(img->name())) {
         // force insert
         cache.remove(img->name());
         cache.insert(img);
+        trimCache();
+    }
+    // same image in full resolution; the view stays as is
+    if(upgrade) {
+        emit fullResolutionReady(img->name());
+        return;
     }
     if(img->name() == mCurrentFileName) {
         emit itemReady(img);
-        if(settings->usePreloader()) {
-            preload(dirManager.prevOf(mCurrentFileName));
-            preload(dirManager.nextOf(mCurrentFileName));
-        }
+        preloadAround();
     }
 }
 
 void DirectoryModel::onSortingChanged() {
     trimCache();
-    if(settings->usePreloader()) {
-        preload(dirManager.prevOf(mCurrentFileName));
-        preload(dirManager.nextOf(mCurrentFileName));
-    }
+    preloadAround();
     emit sortingChanged();
 }
 
@@ -326,22 +328,25 @@ void DirectoryModel::onFileAdded(QString fileName) {
 }
 
 void DirectoryModel::onFileModified(QString fileName) {
+    thumbnailer->forget(fullPath(fileName));
     QDateTime modTime = lastModified(fileName);
-    auto img = getItem(fileName);
-    if(modTime.isValid()) {
-        if(modTime > img->lastModified()) {
-            if(fileName == mCurrentFileName) {
-                reload(fileName);
-            } else {
-                unload(fileName);
-            }
-        }
-        emit fileModified(fileName);
+    if(!modTime.isValid())
+        return;
+    // only what is cached or being loaded needs a refresh; no decoding here
+    auto img = cache.get(fileName);
+    bool outdated = !img || modTime > img->lastModified();
+    if(fileName == mCurrentFileName) {
+        if(outdated)
+            reload(fileName);
+    } else if(img && outdated) {
+        unload(fileName);
     }
+    emit fileModified(fileName);
 }
 
 void DirectoryModel::onFileRemoved(QString fileName, int index) {
     unload(fileName);
+    thumbnailer->forget(fullPath(fileName));
     if(!dirManager.fileCount()) {
         mCurrentFileName = "";
         emit fileRemoved(fileName, index);
@@ -353,13 +358,36 @@ void DirectoryModel::onFileRemoved(QString fileName, int index) {
     }
 }
 
-void DirectoryModel::onFileRenamed(QString from, int indexFrom, QString to, int indexTo) {
-    unload(from);
-    if(mCurrentFileName == from) {
-        cache.clear();
-        setIndex(indexTo);
+void DirectoryModel::onFilesChanged(const DirectoryChanges &changes) {
+    for(auto &fileName : changes.removed) {
+        unload(fileName);
+        thumbnailer->forget(fullPath(fileName));
     }
-    emit fileRenamed(from, indexFrom, to, indexTo);
+    // views first, so that they know the new indices
+    emit filesChanged(changes);
+    if(mCurrentFileName.isEmpty()) {
+        if(!changes.added.isEmpty())
+            setIndexAsync(indexOf(changes.added.first()));
+    } else if(changes.removed.contains(mCurrentFileName)) {
+        QString renamedTo = changes.renamedTo(mCurrentFileName);
+        if(!renamedTo.isEmpty()) {
+            cache.clear();
+            setIndexAsync(indexOf(renamedTo));
+        } else if(!dirManager.fileCount()) {
+            mCurrentFileName = "";
+        } else {
+            // whatever moved into its place
+            int oldIndex = changes.removedIndexOf(mCurrentFileName);
+            int index = oldIndex;
+            for(int removedIndex : changes.removedIndices) {
+                if(removedIndex < oldIndex)
+                    index--;
+            }
+            setIndexAsync(qBound(0, index, itemCount() - 1));
+        }
+    }
+    for(auto &fileName : changes.modified)
+        onFileModified(fileName);
 }
 
 bool DirectoryModel::isLoaded(int index) {
@@ -377,21 +405,115 @@ std::shared_ptr<Image> DirectoryModel::getItemAt(int index) {
 // returns cached image
 // if image is not cached, loads it in the main thread
 // for async access use setIndexAsync(int)
+// always in full resolution, as this is used for editing & saving
 std::shared_ptr<Image> DirectoryModel::getItem(QString fileName) {
     std::shared_ptr<Image> img = cache.get(fileName);
+    if(img && img->isReduced()) {
+        img = loader.loadFullResolution(fullPath(fileName));
+        cache.remove(fileName);
+        cache.insert(img);
+    }
     if(!img)
-        img = loader.load(fullPath(fileName));
+        img = loader.loadFullResolution(fullPath(fileName));
     return img;
 }
 
+// replaces a reduced image in cache once loaded, see fullResolutionReady()
+void DirectoryModel::loadFullResolution(QString fileName) {
+    auto img = cache.get(fileName);
+    if(img && img->isReduced())
+        loader.loadFullResolutionAsync(fullPath(fileName));
+}
+
 void DirectoryModel::updateItem(QString fileName, std::shared_ptr<Image> img) {
     if(dirManager.contains(fileName)) {
         cache.insert(img);
+        thumbnailer->forget(fullPath(fileName));
         emit itemUpdated(fileName);
     }
 }
 
-void DirectoryModel::preload(QString fileName) {
+void DirectoryModel::setRandomizer(Randomizer *_randomizer) {
+    randomizer = _randomizer;
+}
+
+void DirectoryModel::preload(QString fileName, int priority) {
     if(contains(fileName) && !cache.contains(fileName))
-        loader.loadAsync(fullPath(fileName));
+        loader.loadAsync(fullPath(fileName), priority);
+}
+
+// requeues preloading, closest files first
+void DirectoryModel::preloadAround() {
+    QStringList list = preloadList();
+    QStringList keepPaths;
+    keepPaths << fullPath(mCurrentFileName);
+    for(auto fileName : list)
+        keepPaths << fullPath(fileName);
+    // abort decodes the user has moved away from
+    loader.cancelExcept(keepPaths);
+    // keep the current file if it is still queued, requeue the rest
+    loader.clearPending(fullPath(mCurrentFileName));
+    for(int i = 0; i < list.count(); i++)
+        preload(list.at(i), -i);
+}
+
+// files which are likely to be opened next, sorted by distance
+// in shuffle mode these come from the randomizer
+QStringList DirectoryModel::preloadList() {
+    QStringList list;
+    int index = currentIndex();
+    if(!settings->usePreloader() || index == -1)
+        return list;
+    int ahead = settings->preloadAhead();
+    int behind = settings->preloadBehind();
+    // moving fast - look further in the travel direction
+    if(navInterval < FAST_NAVIGATION_INTERVAL)
+        ahead *= 2;
+    int nextCount = navForward ? ahead : behind;
+    int prevCount = navForward ? behind : ahead;
+
+    std::vector<int> next, prev;
+    if(randomizer && settings->shuffleEnabled()) {
+        next = randomizer->peekNext(nextCount);
+        prev = randomizer->peekPrev(prevCount);
+    } else {
+        bool wrap = settings->infiniteScrolling();
+        int count = itemCount();
+        for(int i = 1; i <= nextCount && (wrap || index + i < count); i++)
+            next.push_back((index + i) % count);
+        for(int i = 1; i <= prevCount && (wrap || index - i >= 0); i++)
+            prev.push_back(((index - i) % count + count) % count);
+    }
+    auto &fwd  = navForward ? next : prev;
+    auto &back = navForward ? prev : next;
+    for(size_t i = 0; i < std::max(fwd.size(), back.size()); i++) {
+        if(i < fwd.size())
+            list << fileNameAt(fwd[i]);
+        if(i < back.size())
+            list << fileNameAt(back[i]);
+    }
+    list.removeAll(mCurrentFileName);
+    list.removeAll("");
+    list.removeDuplicates();
+    return list;
+}
+
+void DirectoryModel::updateNavigation(int oldIndex, int newIndex) {
+    if(randomizer && settings->shuffleEnabled()) {
+        navForward = randomizer->forward();
+    } else if(oldIndex != -1 && newIndex != oldIndex) {
+        int last = itemCount() - 1;
+        // wrapped around the end of the list
+        if(oldIndex == last && newIndex == 0)
+            navForward = true;
+        else if(oldIndex == 0 && newIndex == last)
+            navForward = false;
+        else
+            navForward = newIndex > oldIndex;
+    }
+    // smoothed interval between steps
+    if(navTimer.isValid())
+        navInterval = (navInterval * 3 + navTimer.restart()) / 4;
+    else
+        navTimer.start();
 }
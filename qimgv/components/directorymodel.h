@@ -6,6 +6,7 @@
 #include "scaler/scaler.h"
 #include "thumbnailer/thumbnailer.h"
 #include "loader/loader.h"
+#include "utils/randomizer.h"
 
 enum FileOpResult {
     SUCCESS,
@@ -56,6 +57,7 @@ public:
 
     std::shared_ptr<Image> getItemAt(int index);
     std::shared_ptr<Image> getItem(QString fileName);
+    void loadFullResolution(QString fileName);
     void updateItem(QString fileName, std::shared_ptr<Image> img);
     int currentIndex();
     void setSortingMode(SortingMode mode);
@@ -67,17 +69,22 @@ public:
     bool isLoaded(int index);
     bool isLoaded(QString fileName);
     void reload(QString fileName);
+    // used to predict the next files in shuffle mode
+    void setRandomizer(Randomizer *_randomizer);
 signals:
     void fileRemoved(QString fileName, int index);
-    void fileRenamed(QString from, int indexFrom, QString to, int indexTo);
     void fileAdded(QString fileName);
     void fileModified(QString fileName);
+    // external changes, in batches
+    void filesChanged(const DirectoryChanges &changes);
     void loaded(QString);
     void sortingChanged();
     void indexChanged(int oldIndex, int index);
     // returns current item
     void itemReady(std::shared_ptr<Image> img);
     void itemUpdated(QString fileName);
+    // a reduced image got replaced with the full resolution one
+    void fullResolutionReady(QString fileName);
 
     void generateThumbnails(QList<int> indexes, int size, bool, bool);
     void thumbnailReady(std::shared_ptr<Thumbnail>);
@@ -87,9 +94,19 @@ private:
     Loader loader;
     Cache cache;
     Thumbnailer *thumbnailer;
-    void preload(QString fileName);
+    Randomizer *randomizer;
+    void preload(QString fileName, int priority);
+    void preloadAround();
+    QStringList preloadList();
     void trimCache();
 
+    // navigation tracking for the preloader
+    void updateNavigation(int oldIndex, int newIndex);
+    QElapsedTimer navTimer;
+    qint64 navInterval;
+    bool navForward;
+    static const qint64 FAST_NAVIGATION_INTERVAL = 250; // ms between steps
+
     QString mCurrentFileName;
 
 private slots:
@@ -97,6 +114,6 @@ private slots:
     void onSortingChanged();
     void onFileAdded(QString fileName);
     void onFileRemoved(QString fileName, int index);
-    void onFileRenamed(QString from, int indexFrom, QString to, int indexTo);
     void onFileModified(QString fileName);
+    void onFilesChanged(const DirectoryChanges &changes);
 };
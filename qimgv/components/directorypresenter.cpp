@@ -7,7 +7,7 @@ void DirectoryPresenter::unsetModel() {
     disconnect(model.get(), &DirectoryModel::fileRemoved,    this, &DirectoryPresenter::onFileRemoved);
     disconnect(model.get(), &DirectoryModel::fileAdded,      this, &DirectoryPresenter::onFileAdded);
     disconnect(model.get(), &DirectoryModel::fileModified,   this, &DirectoryPresenter::onFileModified);
-    disconnect(model.get(), &DirectoryModel::fileRenamed,    this, &DirectoryPresenter::onFileRenamed);
+    disconnect(model.get(), &DirectoryModel::filesChanged,   this, &DirectoryPresenter::onFilesChanged);
     disconnect(model.get(), &DirectoryModel::indexChanged,   this, &DirectoryPresenter::onIndexChanged);
     disconnect(model.get(), &DirectoryModel::loaded,         this, &DirectoryPresenter::reloadModel);
     disconnect(model.get(), &DirectoryModel::sortingChanged, this, &DirectoryPresenter::onModelSortingChanged);
@@ -31,7 +31,7 @@ void DirectoryPresenter::setModel(std::shared_ptr<DirectoryModel> newModel) {
     connect(model.get(), &DirectoryModel::fileRemoved,    this, &DirectoryPresenter::onFileRemoved);
     connect(model.get(), &DirectoryModel::fileAdded,      this, &DirectoryPresenter::onFileAdded);
     connect(model.get(), &DirectoryModel::fileModified,   this, &DirectoryPresenter::onFileModified);
-    connect(model.get(), &DirectoryModel::fileRenamed,    this, &DirectoryPresenter::onFileRenamed);
+    connect(model.get(), &DirectoryModel::filesChanged,   this, &DirectoryPresenter::onFilesChanged);
     connect(model.get(), &DirectoryModel::indexChanged,   this, &DirectoryPresenter::onIndexChanged);
     connect(model.get(), &DirectoryModel::loaded,         this, &DirectoryPresenter::reloadModel);
     connect(model.get(), &DirectoryModel::sortingChanged, this, &DirectoryPresenter::onModelSortingChanged);
@@ -71,20 +71,10 @@ void DirectoryPresenter::onFileRemoved(QString fileName, int index) {
     }
 }
 
-void DirectoryPresenter::onFileRenamed(QString from, int indexFrom, QString to, int indexTo) {
-    Q_UNUSED(from)
-    Q_UNUSED(to)
-
+// selection of a renamed current file is restored by the model's indexChanged
+void DirectoryPresenter::onFilesChanged(const DirectoryChanges &changes) {
     for(int i=0; i<views.count(); i++) {
-        int selectedIndex = views.at(i)->selectedIndex();
-        views.at(i)->removeItem(indexFrom);
-        views.at(i)->insertItem(indexTo);
-        if(selectedIndex == indexFrom ||
-           selectedIndex == -1)
-        {
-            views.at(i)->selectIndex(indexTo);
-            views.at(i)->focusOn(indexTo);
-        }
+        views.at(i)->applyChanges(changes.removedIndices, changes.addedIndices);
     }
 }
 
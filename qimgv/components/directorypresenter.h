@@ -25,7 +25,7 @@ public slots:
     void loadByIndex(int);
 private slots:
     void onFileRemoved(QString fileName, int index);
-    void onFileRenamed(QString from, int indexFrom, QString to, int indexTo);
+    void onFilesChanged(const DirectoryChanges &changes);
     void onFileAdded(QString fileName);
     void onFileModified(QString fileName);
 
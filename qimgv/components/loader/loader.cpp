@@ -6,34 +6,67 @@ Loader::Loader() {
 }
 
 void Loader::clearTasks() {
-    clearPool();
+    cancelExcept(QStringList());
     pool->waitForDone();
+    // their finished() won't be delivered if we are about to be destroyed
+    qDeleteAll(cancelledTasks);
+    cancelledTasks.clear();
 }
 
 bool Loader::isBusy() {
     return (tasks.count() != 0);
 }
 
+// large images may come in reduced, see decodeSize()
 std::shared_ptr<Image> Loader::load(QString path) {
+    return ImageFactory::createImage(path, nullptr, decodeSize());
+}
+
+std::shared_ptr<Image> Loader::loadFullResolution(QString path) {
     return ImageFactory::createImage(path);
 }
 
 // clears all buffered tasks before loading
 void Loader::loadAsyncPriority(QString path) {
-    clearPool();
-    doLoadAsync(path, 1);
+    clearPending();
+    doLoadAsync(path, 1, decodeSize());
+}
+
+// higher priority tasks are started first
+void Loader::loadAsync(QString path, int priority) {
+    doLoadAsync(path, priority, decodeSize());
 }
 
-void Loader::loadAsync(QString path) {
-    doLoadAsync(path, 0);
+void Loader::loadFullResolutionAsync(QString path) {
+    // started once the current task is done, see onLoadFinished()
+    if(tasks.contains(path)) {
+        fullResolutionPending.insert(path);
+        return;
+    }
+    doLoadAsync(path, 1, QSize());
+}
+
+// a task that is already there for this path may have read the old file
+void Loader::reloadAsync(QString path) {
+    fullResolutionPending.remove(path);
+    auto task = tasks.take(path);
+    if(task) {
+        if(pool->tryTake(task)) {
+            delete task;
+        } else {
+            task->cancel();
+            cancelledTasks.append(task);
+        }
+    }
+    doLoadAsync(path, 1, decodeSize());
 }
 
-void Loader::doLoadAsync(QString path, int priority) {
+void Loader::doLoadAsync(QString path, int priority, QSize decodeSize) {
     if(tasks.contains(path)) {
         return;
     }
 
-    auto runnable = new LoaderRunnable(path);
+    auto runnable = new LoaderRunnable(path, decodeSize);
     runnable->setAutoDelete(false);
     tasks.insert(path, runnable);
     connect(runnable, &LoaderRunnable::finished, this, &Loader::onLoadFinished, Qt::UniqueConnection);
@@ -41,20 +74,61 @@ void Loader::doLoadAsync(QString path, int priority) {
 }
 
 void Loader::onLoadFinished(std::shared_ptr<Image> image, QString path) {
-    auto task = tasks.take(path);
+    auto task = static_cast<LoaderRunnable*>(sender());
+    // nobody is waiting for this one anymore
+    if(cancelledTasks.removeOne(task)) {
+        delete task;
+        return;
+    }
+    // already deleted by clearTasks()
+    if(tasks.value(path) != task)
+        return;
+    tasks.remove(path);
     delete task;
+    bool wantsFullResolution = fullResolutionPending.remove(path);
     if(!image)
         emit loadFailed(path); // due incorrect image format etc
     else
         emit loadFinished(image);
+    if(wantsFullResolution && image && image->isReduced())
+        doLoadAsync(path, 1, QSize());
 }
 
-void Loader::clearPool() {
+// drops tasks which did not start yet
+void Loader::clearPending(QString exceptPath) {
     QHashIterator<QString, LoaderRunnable*> i(tasks);
     while (i.hasNext()) {
         i.next();
-        if(pool->tryTake(i.value())) {
+        if(i.key() != exceptPath && pool->tryTake(i.value())) {
             delete tasks.take(i.key());
+            fullResolutionPending.remove(i.key());
         }
     }
 }
+
+// drops queued tasks and aborts running ones, except for the listed paths
+void Loader::cancelExcept(QStringList keepPaths) {
+    for(auto path : tasks.keys()) {
+        if(keepPaths.contains(path))
+            continue;
+        fullResolutionPending.remove(path);
+        auto task = tasks.take(path);
+        if(pool->tryTake(task)) {
+            delete task;
+        } else {
+            task->cancel();
+            cancelledTasks.append(task);
+        }
+    }
+}
+
+// size of the largest screen in device pixels
+// invalid when screen size decoding is off
+QSize Loader::decodeSize() {
+    QSize size;
+    if(!settings->screenSizeDecoding())
+        return size;
+    for(auto screen : QGuiApplication::screens())
+        size = size.expandedTo(screen->size() * screen->devicePixelRatio());
+    return size;
+}
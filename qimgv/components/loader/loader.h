@@ -2,6 +2,8 @@
 
 #include <QThreadPool>
 #include <QtConcurrent>
+#include <QGuiApplication>
+#include <QScreen>
 #include "components/cache/thumbnailcache.h"
 #include "loaderrunnable.h"
 
@@ -10,16 +12,25 @@ class Loader : public QObject {
 public:
     explicit Loader();
     std::shared_ptr<Image> load(QString path);
+    std::shared_ptr<Image> loadFullResolution(QString path);
     void loadAsyncPriority(QString path);
-    void loadAsync(QString path);
+    void loadAsync(QString path, int priority = 0);
+    void loadFullResolutionAsync(QString path);
+    void reloadAsync(QString path);
 
     void clearTasks();
+    void clearPending(QString exceptPath = "");
+    void cancelExcept(QStringList keepPaths);
     bool isBusy();
 private:
     QHash<QString, LoaderRunnable*> tasks;
-    QThreadPool *pool;    
-    void clearPool();
-    void doLoadAsync(QString path, int priority);
+    // aborted tasks which are still winding down
+    QList<LoaderRunnable*> cancelledTasks;
+    // full resolution was asked for while a reduced decode was running
+    QSet<QString> fullResolutionPending;
+    QThreadPool *pool;
+    void doLoadAsync(QString path, int priority, QSize decodeSize);
+    QSize decodeSize();
 
 signals:
     void loadFinished(std::shared_ptr<Image>);
@@ -2,13 +2,21 @@
 
 #include <QElapsedTimer>
 
-LoaderRunnable::LoaderRunnable(QString _path) : path(_path) {
+LoaderRunnable::LoaderRunnable(QString _path, QSize _decodeSize)
+    : path(_path),
+      decodeSize(_decodeSize),
+      cancelled(false)
+{
 }
 
 void LoaderRunnable::run() {
     //QElapsedTimer t;
     //t.start();
-    auto image = ImageFactory::createImage(path);
+    auto image = ImageFactory::createImage(path, &cancelled, decodeSize);
     //qDebug() << "L: " << t.elapsed();
     emit finished(image, path);
 }
+
+void LoaderRunnable::cancel() {
+    cancelled = true;
+}
@@ -2,16 +2,21 @@
 
 #include <QObject>
 #include <QRunnable>
+#include <atomic>
 #include "utils/imagefactory.h"
 
 class LoaderRunnable: public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    LoaderRunnable(QString _path);
+    LoaderRunnable(QString _path, QSize _decodeSize);
     void run();
+    // aborts decoding if already running; finished() is still emitted with nullptr
+    void cancel();
 private:
     QString path;
+    QSize decodeSize;
+    std::atomic_bool cancelled;
 signals:
     void finished(std::shared_ptr<Image>, QString);
 };
@@ -6,6 +6,9 @@
  * 3a if during scaling no new requests came, we return the result and forget about it. end.
  * 3b if some requests did come, by the end of current task we dispose of its result,
  *    start the last task that came and ignore the middle ones.
+ *
+ * Slow requests first deliver a cheap preview via scalingPreview(), then the
+ * full quality result. A new request cancels such refinement pass early.
  */
 
 Scaler::Scaler(Cache *_cache, QObject *parent)
@@ -22,8 +25,10 @@ Scaler::Scaler(Cache *_cache, QObject *parent)
     runnable->setAutoDelete(false);
     connect(this, &Scaler::startBufferedRequest, this, &Scaler::slotStartBufferedRequest, Qt::DirectConnection);
     connect(runnable, &ScalerRunnable::started, this, &Scaler::onTaskStart, Qt::DirectConnection);
+    connect(runnable, &ScalerRunnable::preview, this, &Scaler::onTaskPreview, Qt::DirectConnection);
     connect(runnable, &ScalerRunnable::finished, this, &Scaler::onTaskFinish, Qt::DirectConnection);
     connect(this, &Scaler::acceptScalingResult, this, &Scaler::slotForwardScaledResult, Qt::QueuedConnection);
+    connect(this, &Scaler::acceptPreviewResult, this, &Scaler::slotForwardPreviewResult, Qt::QueuedConnection);
 }
 
 void Scaler::requestScaled(ScalerRequest req) {
@@ -74,6 +79,8 @@ void Scaler::requestScaled(ScalerRequest req) {
                 buffered = true;
             }
         }
+        // no point finishing a slow refinement pass nobody will see
+        runnable->cancel();
     }
     sem->release(1);
 }
@@ -90,6 +97,16 @@ void Scaler::onTaskStart(ScalerRequest req) {
     sem->release(1);
 }
 
+void Scaler::onTaskPreview(QImage *scaled, ScalerRequest req) {
+    sem->acquire(1);
+    bool outdated = buffered;
+    sem->release(1);
+    if(outdated)
+        delete scaled;
+    else
+        emit acceptPreviewResult(scaled, req);
+}
+
 void Scaler::onTaskFinish(QImage *scaled, ScalerRequest req) {
     sem->acquire(1);
     running = false;
@@ -108,7 +125,8 @@ void Scaler::onTaskFinish(QImage *scaled, ScalerRequest req) {
         sem->release(1);
     } else {
         sem->release(1);
-        emit acceptScalingResult(scaled, req);
+        if(scaled)
+            emit acceptScalingResult(scaled, req);
     }
 }
 
@@ -123,6 +141,13 @@ void Scaler::slotForwardScaledResult(QImage *image, ScalerRequest req) {
     emit scalingFinished(pixmap, req);
 }
 
+void Scaler::slotForwardPreviewResult(QImage *image, ScalerRequest req) {
+    QPixmap *pixmap = new QPixmap();
+    *pixmap = QPixmap::fromImage(*image);
+    delete image;
+    emit scalingPreview(pixmap, req);
+}
+
 void Scaler::startRequest(ScalerRequest req) {
     runnable->setRequest(req);
     pool->start(runnable);
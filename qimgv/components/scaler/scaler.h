@@ -17,7 +17,9 @@ public:
 
 signals:
     void scalingFinished(QPixmap* result, ScalerRequest request);
+    void scalingPreview(QPixmap* result, ScalerRequest request);
     void acceptScalingResult(QImage *image, ScalerRequest req);
+    void acceptPreviewResult(QImage *image, ScalerRequest req);
     void startBufferedRequest();
 
 public slots:
@@ -25,9 +27,11 @@ public slots:
 
 private slots:
     void onTaskStart(ScalerRequest req);
+    void onTaskPreview(QImage* scaled, ScalerRequest req);
     void onTaskFinish(QImage* scaled, ScalerRequest req);
     void slotStartBufferedRequest();
     void slotForwardScaledResult(QImage *image, ScalerRequest req);
+    void slotForwardPreviewResult(QImage *image, ScalerRequest req);
 
 private:
     QThreadPool *pool;
@@ -2,36 +2,81 @@
 
 #include <QElapsedTimer>
 
-ScalerRunnable::ScalerRunnable() {
+ScalerRunnable::ScalerRunnable() : cancelled(false) {
+    // rough starting points, replaced by measurements as we go
+    timings.insert(FILTER_BILINEAR,   4.0);
+    timings.insert(FILTER_BICUBIC,    6.0);
+    timings.insert(FILTER_CATMULLROM, 6.0);
+    timings.insert(FILTER_LANCZOS,    8.0);
 }
 
 void ScalerRunnable::setRequest(ScalerRequest r) {
     req = r;
+    cancelled = false;
+}
+
+void ScalerRunnable::cancel() {
+    cancelled = true;
+}
+
+// when zoomed out, scale from the closest mipmap level instead of the full image
+std::shared_ptr<const QImage> ScalerRunnable::sourceFor(const ScalerRequest &r) {
+    if(r.image->type() == STATIC) {
+        auto imgStatic = dynamic_cast<ImageStatic *>(r.image.get());
+        return imgStatic->getMipmap(r.size);
+    }
+    return r.image->getImage();
+}
+
+// separable resampling cost follows the source size when downscaling
+// and the target size when upscaling
+double ScalerRunnable::workload(QSize source, QSize target) const {
+    qint64 pixels = qMax(static_cast<qint64>(source.width()) * source.height(),
+                         static_cast<qint64>(target.width()) * target.height());
+    return pixels / 1000000.0;
+}
+
+double ScalerRunnable::estimate(ScalingFilter filter, double megapixels) const {
+    return timings.value(filter, 0.0) * megapixels;
+}
+
+// best filter below the requested one that still fits into a frame
+ScalingFilter ScalerRunnable::previewFilter(double megapixels) const {
+    for(int f = req.filter - 1; f > FILTER_NEAREST; f--) {
+        if(estimate(static_cast<ScalingFilter>(f), megapixels) <= FRAME_BUDGET_MS)
+            return static_cast<ScalingFilter>(f);
+    }
+    return FILTER_NEAREST;
+}
+
+void ScalerRunnable::updateTiming(ScalingFilter filter, double megapixels, qint64 elapsed) {
+    if(filter == FILTER_NEAREST || megapixels < MIN_MEASURED_MEGAPIXELS)
+        return;
+    timings[filter] = timings.value(filter) * 0.75 + (elapsed / megapixels) * 0.25;
 }
 
 void ScalerRunnable::run() {
     emit started(req);
-    //QElapsedTimer t;
-    //t.start();
-    QImage *scaled = nullptr;
-    if(req.filter == 0 || (req.size.width() > req.image->width() && !settings->smoothUpscaling())) {
-        scaled = ImageLib::scaled(req.image->getImage(), req.size, 0);
-    } else {
-        /*
-        // This is an estimation based on image size and depth.
-        // If complexity is above CMPL_FALLBACK_THRESHOLD we fall back to faster (bilinear) filter.
-        // Hopefully this will prevent noticeable lag during scaling.
-        float complexity = static_cast<float>(req.size.width()) *
-                           static_cast<float>(req.size.height()) *
-                           static_cast<float>(req.image->getImage()->depth()) / 8000000.f;
-        if(complexity > CMPL_FALLBACK_THRESHOLD) {
-            scaled = ImageLib::scaled(req.image->getImage(), req.size, 1);
-        } else {
-            scaled = ImageLib::scaled(req.image->getImage(), req.size, settings->scalingFilter());
-        }
-        */
-        scaled = ImageLib::scaled(req.image->getImage(), req.size, req.filter);
+    if(req.filter == FILTER_NEAREST || (req.size.width() > req.image->width() && !settings->smoothUpscaling())) {
+        emit finished(ImageLib::scaled(req.image->getImage(), req.size, FILTER_NEAREST), req);
+        return;
+    }
+    auto source = sourceFor(req);
+    double megapixels = workload(source->size(), req.size);
+    QElapsedTimer t;
+    // too slow for one frame: show something cheap right away, then refine.
+    // the refinement can be dropped if a newer request comes in meanwhile
+    bool refining = estimate(req.filter, megapixels) > FRAME_BUDGET_MS;
+    if(refining) {
+        ScalingFilter filter = previewFilter(megapixels);
+        t.start();
+        QImage *quick = ImageLib::scaled(source, req.size, filter);
+        updateTiming(filter, megapixels, t.elapsed());
+        emit preview(quick, req);
     }
-    //qDebug() << ">> " << req.size << ": " << t.elapsed();
+    t.start();
+    QImage *scaled = ImageLib::scaled(source, req.size, req.filter, refining ? &cancelled : nullptr);
+    if(scaled)
+        updateTiming(req.filter, megapixels, t.elapsed());
     emit finished(scaled, req);
 }
@@ -3,7 +3,9 @@
 #include <QObject>
 #include <QRunnable>
 #include <QThread>
+#include <QMap>
 #include <QDebug>
+#include <atomic>
 #include "components/cache/cache.h"
 #include "scalerrequest.h"
 #include "utils/imagelib.h"
@@ -16,11 +18,25 @@ public:
     explicit ScalerRunnable();
     void setRequest(ScalerRequest r);
     void run();
+    // abort the refinement pass (if one is running)
+    void cancel();
 signals:
     void started(ScalerRequest);
+    void preview(QImage*, ScalerRequest);
     void finished(QImage*, ScalerRequest);
 
 private:
     ScalerRequest req;
-    const float CMPL_FALLBACK_THRESHOLD = 70.0; // equivalent of ~ 5000x3500 @ 32bpp
+    std::atomic_bool cancelled;
+    // measured on this machine, ms per megapixel of work
+    QMap<ScalingFilter, double> timings;
+    std::shared_ptr<const QImage> sourceFor(const ScalerRequest &r);
+    double workload(QSize source, QSize target) const;
+    double estimate(ScalingFilter filter, double megapixels) const;
+    ScalingFilter previewFilter(double megapixels) const;
+    void updateTiming(ScalingFilter filter, double megapixels, qint64 elapsed);
+    // anything slower than this gets a quick preview first
+    const double FRAME_BUDGET_MS = 16.0;
+    // smaller jobs are too noisy to learn from
+    const double MIN_MEASURED_MEGAPIXELS = 0.5;
 };
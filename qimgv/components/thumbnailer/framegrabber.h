@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QImage>
+#include <QString>
+
+// Decodes single video frames without a window.
+// Not thread safe: use one instance per thread.
+class FrameGrabber {
+public:
+    virtual ~FrameGrabber() {}
+    // position is a fraction of the duration.
+    // The frame is downscaled so that its shorter side is shortSide; videoSize is the native size.
+    virtual bool grab(const QString &path, double position, int shortSide, QImage &frame, QSize &videoSize) = 0;
+};
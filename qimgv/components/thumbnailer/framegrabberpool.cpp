@@ -0,0 +1,77 @@
+#include "framegrabberpool.h"
+
+FrameGrabberPool::FrameGrabberPool(int _maxGrabbers)
+    : maxGrabbers(qMax(_maxGrabbers, 1)),
+      initialized(false),
+      createFn(nullptr)
+{
+}
+
+FrameGrabberPool::~FrameGrabberPool() {
+    qDeleteAll(grabbers);
+}
+
+// called with the mutex locked
+void FrameGrabberPool::init() {
+    if(initialized)
+        return;
+    initialized = true;
+#ifdef USE_MPV
+#ifdef __linux
+    playerLib.setFileName("qimgv_player_mpv");
+#else
+    playerLib.setFileName("libqimgv_player_mpv.dll");
+#endif
+    createFn = reinterpret_cast<createFrameGrabberFn>(playerLib.resolve("CreateFrameGrabber"));
+    // try one right away so that we know whether to fall back
+    FrameGrabber *grabber = createFn ? createFn() : nullptr;
+    if(!grabber) {
+        qDebug() << "[FrameGrabberPool] frame grabbing is not supported by" << playerLib.fileName();
+        createFn = nullptr;
+        return;
+    }
+    grabbers.append(grabber);
+    idle.append(grabber);
+#endif
+}
+
+bool FrameGrabberPool::isAvailable() {
+    QMutexLocker locker(&mutex);
+    init();
+    return createFn != nullptr;
+}
+
+FrameGrabber *FrameGrabberPool::acquire() {
+    QMutexLocker locker(&mutex);
+    init();
+    if(!createFn)
+        return nullptr;
+    while(idle.isEmpty()) {
+        if(grabbers.count() < maxGrabbers) {
+            FrameGrabber *grabber = createFn();
+            if(grabber) {
+                grabbers.append(grabber);
+                return grabber;
+            }
+            // couldn't make another one, wait for the existing ones
+            maxGrabbers = grabbers.count();
+        }
+        grabberReleased.wait(&mutex);
+    }
+    return idle.takeLast();
+}
+
+void FrameGrabberPool::release(FrameGrabber *grabber) {
+    QMutexLocker locker(&mutex);
+    idle.append(grabber);
+    grabberReleased.wakeOne();
+}
+
+bool FrameGrabberPool::grab(QString path, double position, int shortSide, QImage &frame, QSize &videoSize) {
+    FrameGrabber *grabber = acquire();
+    if(!grabber)
+        return false;
+    bool ok = grabber->grab(path, position, shortSide, frame, videoSize);
+    release(grabber);
+    return ok;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QLibrary>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QList>
+#include <QDebug>
+#include "components/thumbnailer/framegrabber.h"
+
+// Long-lived video frame grabbers from the mpv player library, shared by thumbnailer threads.
+// Grabbers are created on first use and reused for every following video.
+class FrameGrabberPool {
+public:
+    explicit FrameGrabberPool(int _maxGrabbers);
+    ~FrameGrabberPool();
+    // false if the player library is missing or can't grab frames
+    bool isAvailable();
+    // blocks until a grabber is free
+    bool grab(QString path, double position, int shortSide, QImage &frame, QSize &videoSize);
+
+private:
+    typedef FrameGrabber* (*createFrameGrabberFn)();
+
+    QMutex mutex;
+    QWaitCondition grabberReleased;
+    QList<FrameGrabber*> idle;
+    QList<FrameGrabber*> grabbers;
+    int maxGrabbers;
+    bool initialized;
+    QLibrary playerLib;
+    createFrameGrabberFn createFn;
+
+    void init();
+    FrameGrabber *acquire();
+    void release(FrameGrabber *grabber);
+};
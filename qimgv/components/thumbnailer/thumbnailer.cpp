@@ -1,6 +1,12 @@
 #include "thumbnailer.h"
 
-Thumbnailer::Thumbnailer(DirectoryManager *_dm) : dm(_dm) {
+Thumbnailer::Thumbnailer(DirectoryManager *_dm, Loader *_loader)
+    : dm(_dm),
+      loader(_loader),
+      jobCounter(0),
+      memoryCache(MEMORY_CACHE_BUDGET_KB),
+      backgroundSize(0)
+{
     thumbnailCache = new ThumbnailCache();
     pool = new QThreadPool(this);
     int threads = settings->thumbnailerThreadCount();
@@ -8,38 +14,186 @@ Thumbnailer::Thumbnailer(DirectoryManager *_dm) : dm(_dm) {
     if(threads > globalThreads)
         threads = globalThreads;
     pool->setMaxThreadCount(threads);
+    frameGrabbers = new FrameGrabberPool(threads);
+    backgroundPool = new QThreadPool(this);
+    backgroundPool->setMaxThreadCount(1);
+
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(IDLE_DELAY_MS);
+    connect(&idleTimer, &QTimer::timeout, this, &Thumbnailer::onIdle);
+    connect(dm, &DirectoryManager::loaded, this, &Thumbnailer::deferBackgroundWork);
+    // indexes changed; the background pass just starts over, done files are quick to skip
+    connect(dm, &DirectoryManager::sortingChanged, this, &Thumbnailer::resetBackgroundCursor);
+}
+
+Thumbnailer::~Thumbnailer() {
+    clearTasks();
+    // flushes queued thumbnails to disk
+    delete thumbnailCache;
+    delete frameGrabbers;
 }
 
 void Thumbnailer::clearTasks() {
-    pool->clear();
+    idleTimer.stop();
+    pending.clear();
+    for(auto &job : running)
+        *job.cancelled = true;
+    if(backgroundCancelled)
+        *backgroundCancelled = true;
     pool->waitForDone();
+    backgroundPool->waitForDone();
+    running.clear();
+    backgroundCancelled = nullptr;
+}
+
+void Thumbnailer::forget(QString path) {
+    QString prefix = path + "\n";
+    for(auto &key : memoryCache.keys()) {
+        if(key.startsWith(prefix))
+            memoryCache.remove(key);
+    }
+}
+
+QString Thumbnailer::jobKey(QString path, int size, bool cropSquare) const {
+    return path + "\n" + QString::number(size) + (cropSquare ? "s" : "");
 }
 
 void Thumbnailer::generateThumbnails(QList<int> indexes, int size, bool cropSquare, bool forceGenerate) {
-    pool->clear();
+    deferBackgroundWork();
+    backgroundSize = qMax(backgroundSize, size);
+    QSet<QString> requested;
     for(int i = 0; i < indexes.count(); i++) {
         if(!dm->checkRange(indexes[i]))
             continue;
         QString filePath = dm->filePathAt(indexes[i]);
-        if(!runningTasks.contains(filePath, size)) {
-            startThumbnailerThread(filePath, size, cropSquare, forceGenerate);
+        QString key = jobKey(filePath, size, cropSquare);
+        requested.insert(key);
+        if(!forceGenerate) {
+            auto cached = memoryCache.object(key);
+            if(cached) {
+                emit thumbnailReady(*cached);
+                pending.remove(key);
+                continue;
+            }
+        }
+        auto run = running.find(key);
+        // forced requests want a fresh result even if one is being made right now
+        if(run != running.end() && !*run->cancelled && !forceGenerate)
+            continue;
+        auto job = pending.find(key);
+        if(job != pending.end()) {
+            job->rank = i;
+            job->forceGenerate |= forceGenerate;
+        } else {
+            pending.insert(key, { filePath, size, cropSquare, forceGenerate, i });
         }
     }
+    // forget what this view doesn't need anymore
+    for(auto it = pending.begin(); it != pending.end();) {
+        if(it->size == size && it->cropSquare == cropSquare && !requested.contains(it.key()))
+            it = pending.erase(it);
+        else
+            ++it;
+    }
+    for(auto it = running.begin(); it != running.end(); ++it) {
+        if(it->size == size && it->cropSquare == cropSquare && !requested.contains(it.key()))
+            *it->cancelled = true;
+    }
+    startJobs();
 }
 
-void Thumbnailer::startThumbnailerThread(QString filePath, int size, bool cropSquare, bool forceGenerate) {
-    auto runnable = new ThumbnailerRunnable(thumbnailCache, filePath, size, cropSquare, forceGenerate);
-    connect(runnable, &ThumbnailerRunnable::taskStart, this, &Thumbnailer::onTaskStart);
-    connect(runnable, &ThumbnailerRunnable::taskEnd, this, &Thumbnailer::onTaskEnd);
+// fill free threads with the best ranked jobs
+void Thumbnailer::startJobs() {
+    int freeThreads = pool->maxThreadCount() - running.count();
+    if(freeThreads <= 0 || pending.isEmpty())
+        return;
+    QList<QString> keys = pending.keys();
+    std::sort(keys.begin(), keys.end(), [this](const QString &a, const QString &b) {
+        return pending[a].rank < pending[b].rank;
+    });
+    for(int i = 0; i < keys.count() && freeThreads > 0; i++) {
+        // wait for the previous (cancelled) job with this key to finish
+        if(running.contains(keys[i]))
+            continue;
+        startThumbnailerThread(keys[i], pending.take(keys[i]));
+        freeThreads--;
+    }
+}
+
+void Thumbnailer::startThumbnailerThread(QString key, PendingJob job) {
+    quint64 id = ++jobCounter;
+    std::shared_ptr<std::atomic_bool> cancelled(new std::atomic_bool(false));
+    running.insert(key, { id, job.size, job.cropSquare, cancelled });
+    auto runnable = new ThumbnailerRunnable(thumbnailCache, frameGrabbers, job.path, job.size, job.cropSquare, job.forceGenerate, cancelled);
+    connect(runnable, &ThumbnailerRunnable::taskEnd, this, [this, key, id](std::shared_ptr<Thumbnail> thumbnail, QString) {
+        onTaskEnd(key, id, thumbnail);
+    });
     runnable->setAutoDelete(true);
     pool->start(runnable);
 }
 
-void Thumbnailer::onTaskStart(QString path, int size) {
-    runningTasks.insert(path, size);
+// thumbnail is null if the job was cancelled
+void Thumbnailer::onTaskEnd(QString key, quint64 id, std::shared_ptr<Thumbnail> thumbnail) {
+    auto run = running.find(key);
+    if(run != running.end() && run->id == id)
+        running.erase(run);
+    if(thumbnail) {
+        auto pixmap = thumbnail->pixmap();
+        if(pixmap && !pixmap->isNull()) {
+            int cost = static_cast<int>(static_cast<qint64>(pixmap->width()) * pixmap->height() * pixmap->depth() / 8 / 1024) + 1;
+            memoryCache.insert(key, new std::shared_ptr<Thumbnail>(thumbnail), cost);
+        }
+        emit thumbnailReady(thumbnail);
+    }
+    startJobs();
 }
 
-void Thumbnailer::onTaskEnd(std::shared_ptr<Thumbnail> thumbnail, QString path) {
-    runningTasks.remove(path, thumbnail->size());
-    emit thumbnailReady(thumbnail);
+void Thumbnailer::deferBackgroundWork() {
+    // stop hogging the disk, the file we were on will be redone later
+    if(backgroundCancelled)
+        *backgroundCancelled = true;
+    idleTimer.start();
+}
+
+void Thumbnailer::resetBackgroundCursor() {
+    backgroundCursors.remove(dm->directory());
+    deferBackgroundWork();
+}
+
+void Thumbnailer::onIdle() {
+    if(!settings->useThumbnailCache() || backgroundCancelled)
+        return;
+    // still busy with something the user is waiting for
+    if(!pending.isEmpty() || !running.isEmpty() || (loader && loader->isBusy())) {
+        idleTimer.start();
+        return;
+    }
+    QString dir = dm->directory();
+    int index = backgroundCursors.value(dir, 0);
+    if(!dm->checkRange(index))
+        return;
+    // same base size the views would use, so the result is useful to them
+    int size = qMax(backgroundSize, static_cast<int>(qApp->devicePixelRatio() * settings->folderViewIconSize()));
+    std::shared_ptr<std::atomic_bool> cancelled(new std::atomic_bool(false));
+    backgroundCancelled = cancelled;
+    auto runnable = new ThumbnailerRunnable(thumbnailCache, frameGrabbers, dm->filePathAt(index), size, false, false, cancelled);
+    runnable->setStoreOnly(true);
+    connect(runnable, &ThumbnailerRunnable::taskEnd, this, [this, dir, index, cancelled](std::shared_ptr<Thumbnail>, QString) {
+        onBackgroundTaskEnd(dir, index, cancelled);
+    });
+    runnable->setAutoDelete(true);
+    backgroundPool->start(runnable);
+}
+
+void Thumbnailer::onBackgroundTaskEnd(QString dir, int index, std::shared_ptr<std::atomic_bool> cancelled) {
+    if(backgroundCancelled == cancelled)
+        backgroundCancelled = nullptr;
+    if(*cancelled) {
+        if(!idleTimer.isActive())
+            idleTimer.start();
+        return;
+    }
+    backgroundCursors.insert(dir, index + 1);
+    if(!idleTimer.isActive())
+        onIdle();
 }
@@ -1,33 +1,89 @@
 #pragma once
 
 #include <QThreadPool>
+#include <QCache>
+#include <QTimer>
 #include <QtConcurrent>
+#include <atomic>
 #include "components/directorymanager/directorymanager.h"
 #include "components/thumbnailer/thumbnailerrunnable.h"
 #include "components/cache/thumbnailcache.h"
 #include "components/cache/cache.h"
+#include "components/loader/loader.h"
 #include "settings.h"
 
+/* Jobs are keyed by (path, size, crop) and never queued or run twice.
+ * Each request carries its items ordered by priority (closest to the viewport center first).
+ * A new request re-ranks the queue. Queued work of the same size/crop that is no longer
+ * requested is dropped, running jobs for it are cancelled. Requests with a different
+ * size/crop (i.e. from another view) are left alone.
+ *
+ * Finished thumbnails are also kept in memory (lru, bounded by pixmap size)
+ * so that scrolling back doesn't go through the disk cache again.
+ *
+ * When nothing happens for a while the rest of the directory is pregenerated
+ * into the disk cache, one file at a time on an idle priority thread.
+ * Any thumbnail request or navigation pauses it; the position is remembered per directory.
+ */
 class Thumbnailer : public QObject
 {
     Q_OBJECT
 public:
-    explicit Thumbnailer(DirectoryManager *_dm);
+    explicit Thumbnailer(DirectoryManager *_dm, Loader *_loader);
+    ~Thumbnailer();
     void clearTasks();
+    // drops in-memory thumbnails of a file, call when it changes on disk
+    void forget(QString path);
+    // call on user activity; background work resumes after a quiet period
+    void deferBackgroundWork();
 
 public slots:
     void generateThumbnails(QList<int> indexes, int size, bool cropSquare, bool forceRegenerate);
 
 private:
+    struct PendingJob {
+        QString path;
+        int size;
+        bool cropSquare;
+        bool forceGenerate;
+        int rank;
+    };
+    struct RunningJob {
+        quint64 id;
+        int size;
+        bool cropSquare;
+        std::shared_ptr<std::atomic_bool> cancelled;
+    };
+
     ThumbnailCache *thumbnailCache;
-    QThreadPool *pool;
-    void startThumbnailerThread(QString filePath, int size, bool cropSquare, bool forceGenerate);
+    FrameGrabberPool *frameGrabbers;
+    QThreadPool *pool, *backgroundPool;
     DirectoryManager *dm;
-    QMultiMap<QString, int> runningTasks;
+    Loader *loader;
+    QHash<QString, PendingJob> pending;
+    QHash<QString, RunningJob> running;
+    quint64 jobCounter;
+    // cost is in KB
+    QCache<QString, std::shared_ptr<Thumbnail>> memoryCache;
+    static const int MEMORY_CACHE_BUDGET_KB = 160 * 1024;
+
+    QTimer idleTimer;
+    // next file index to pregenerate, per directory
+    QHash<QString, int> backgroundCursors;
+    // the largest size views asked for
+    int backgroundSize;
+    std::shared_ptr<std::atomic_bool> backgroundCancelled;
+    static const int IDLE_DELAY_MS = 3000;
+
+    QString jobKey(QString path, int size, bool cropSquare) const;
+    void startJobs();
+    void startThumbnailerThread(QString key, PendingJob job);
 
 private slots:
-    void onTaskStart(QString path, int size);
-    void onTaskEnd(std::shared_ptr<Thumbnail> thumbnail, QString path);
+    void onTaskEnd(QString key, quint64 id, std::shared_ptr<Thumbnail> thumbnail);
+    void onIdle();
+    void onBackgroundTaskEnd(QString dir, int index, std::shared_ptr<std::atomic_bool> cancelled);
+    void resetBackgroundCursor();
 
 signals:
     void thumbnailReady(std::shared_ptr<Thumbnail>);
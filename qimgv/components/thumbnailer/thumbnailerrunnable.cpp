@@ -1,46 +1,101 @@
 #include "thumbnailerrunnable.h"
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 // TODO: this turned into a spaghetti. nuke and rewrite
 
-ThumbnailerRunnable::ThumbnailerRunnable(ThumbnailCache* _thumbnailCache, QString _path, int _size, bool _squared, bool _forceGenerate) :
+ThumbnailerRunnable::ThumbnailerRunnable(ThumbnailCache* _thumbnailCache, FrameGrabberPool *_frameGrabbers, QString _path, int _size, bool _squared, bool _forceGenerate,
+                                         std::shared_ptr<const std::atomic_bool> _cancelled) :
     path(_path),
     size(_size),
     squared(_squared),
     forceGenerate(_forceGenerate),
-    thumbnailCache(_thumbnailCache)
+    storeOnly(false),
+    thumbnailCache(_thumbnailCache),
+    frameGrabbers(_frameGrabbers),
+    cancelled(_cancelled)
 {
 }
 
+void ThumbnailerRunnable::setStoreOnly(bool mode) {
+    storeOnly = mode;
+}
+
+// idle cpu & io class for the calling thread
+static void setIdlePriority() {
+    QThread::currentThread()->setPriority(QThread::IdlePriority);
+#ifdef __linux__
+    // ioprio_set(IOPRIO_WHO_PROCESS, this thread, IOPRIO_CLASS_IDLE); there is no libc wrapper
+    syscall(SYS_ioprio_set, 1, 0, 3 << 13);
+#endif
+}
+
+bool ThumbnailerRunnable::isCancelled() const {
+    return cancelled && *cancelled;
+}
+
 void ThumbnailerRunnable::run() {
-    emit taskStart(path, size);
-    DocumentInfo imgInfo(path);
-    QString tmpName = imgInfo.fileName();
+    if(isCancelled()) {
+        emit taskEnd(nullptr, path);
+        return;
+    }
+    if(storeOnly)
+        setIdlePriority();
     QString thumbnailId = generateIdString();
-    std::unique_ptr<QImage> image;
+    bool useCache = !forceGenerate && settings->useThumbnailCache();
+    // background pass: one index lookup, neither the file nor the record is read
+    if(storeOnly && useCache && thumbnailCache->exists(thumbnailId)) {
+        emit taskEnd(nullptr, path);
+        return;
+    }
+    QString tmpName = QFileInfo(path).fileName();
+    std::unique_ptr<QImage> base;
 
-    if(!forceGenerate && settings->useThumbnailCache())
-        image.reset(thumbnailCache->readThumbnail(thumbnailId));
+    if(useCache) {
+        base.reset(thumbnailCache->readThumbnail(thumbnailId));
+        // too small for this size; go back to the file
+        if(base && !canDerive(*base, size))
+            base.reset();
+    }
 
-    if(!image) {
-        image.reset(createThumbnailImage(&imgInfo, size, squared));
-        image = ImageLib::exifRotated(std::move(image), imgInfo.exifOrientation());
+    if(!base) {
+        DocumentInfo imgInfo(path);
+        base.reset(createBaseImage(&imgInfo, size));
+        // decoding got interrupted, don't save or show a partial result
+        if(isCancelled()) {
+            emit taskEnd(nullptr, path);
+            return;
+        }
+        base = ImageLib::exifRotated(std::move(base), imgInfo.exifOrientation());
 
         // put in image info
-        image.get()->setText("originalWidth", QString::number(originalSize.width()));
-        image.get()->setText("originalHeight", QString::number(originalSize.height()));
+        base.get()->setText("originalWidth", QString::number(originalSize.width()));
+        base.get()->setText("originalHeight", QString::number(originalSize.height()));
+        base.get()->setText("baseSize", QString::number(size));
+        bool downscaled = qMax(originalSize.width(), originalSize.height()) >
+                          qMax(base->width(), base->height());
+        if(!downscaled)
+            base.get()->setText("baseFull", "1");
 
         if(imgInfo.type() == ANIMATED)
-            image.get()->setText("label", " [a]");
+            base.get()->setText("label", " [a]");
         else if(imgInfo.type() == VIDEO)
-            image.get()->setText("label", " [v]");
+            base.get()->setText("label", " [v]");
 
         if(settings->useThumbnailCache()) {
             // save thumbnail if it makes sense
-            // FIXME: avoid too much i/o
-            if(originalSize.width() > size || originalSize.height() > size)
-                thumbnailCache->saveThumbnail(image.get(), thumbnailId);
+            if(downscaled)
+                thumbnailCache->saveThumbnail(base.get(), thumbnailId);
         }
     }
+    if(storeOnly) {
+        emit taskEnd(nullptr, path);
+        return;
+    }
+    std::unique_ptr<QImage> image(deriveThumbnail(*base, size, squared));
     auto && tmpPixmap = new QPixmap(image->size());
     *tmpPixmap = QPixmap::fromImage(*image);
     tmpPixmap->setDevicePixelRatio(qApp->devicePixelRatio());
@@ -50,24 +105,56 @@ void ThumbnailerRunnable::run() {
         tmpLabel = "error";
     } else  {
         // put info into Thumbnail object
-        tmpLabel = image.get()->text("originalWidth") + "x" +
-                   image.get()->text("originalHeight") +
-                   image.get()->text("label");
+        tmpLabel = base.get()->text("originalWidth") + "x" +
+                   base.get()->text("originalHeight") +
+                   base.get()->text("label");
     }
     std::shared_ptr<const QPixmap> pixmapPtr(tmpPixmap);
     std::shared_ptr<Thumbnail> thumbnail(new Thumbnail(tmpName, tmpLabel, size, pixmapPtr));
     emit taskEnd(thumbnail, path);
 }
 
+// One image is stored per file, all sizes and crop modes are made from it.
 QString ThumbnailerRunnable::generateIdString() {
-    QString queryStr = path + QString::number(size);
-    if(squared)
-        queryStr.append("s");
-    queryStr = QString("%1").arg(QString(QCryptographicHash::hash(queryStr.toUtf8(),QCryptographicHash::Md5).toHex()));
-    return queryStr;
+    return QString(QCryptographicHash::hash(path.toUtf8(), QCryptographicHash::Md5).toHex());
+}
+
+// The stored image serves every size up to the one it was made for,
+// or any size if it holds the whole original.
+bool ThumbnailerRunnable::canDerive(const QImage &base, int size) {
+    return base.text("baseFull") == "1" || base.text("baseSize").toInt() >= size;
 }
 
-QImage* ThumbnailerRunnable::createThumbnailImage(DocumentInfo *imgInfo, int size, bool squared) {
+// Short side covers `size` so that square crops can be cut from it.
+// Very long images are capped instead. Never upscales.
+QSize ThumbnailerRunnable::baseSizeFor(QSize fullSize, int size) {
+    QSize base = fullSize.scaled(size, size, Qt::KeepAspectRatioByExpanding);
+    int maxSide = size * MAX_BASE_ASPECT;
+    if(base.width() > maxSide || base.height() > maxSide)
+        base = fullSize.scaled(maxSide, maxSide, Qt::KeepAspectRatio);
+    if(base.width() > fullSize.width() || base.height() > fullSize.height())
+        base = fullSize;
+    return base;
+}
+
+QImage* ThumbnailerRunnable::deriveThumbnail(const QImage &base, int size, bool squared) {
+    if(!squared)
+        return new QImage(base.scaled(size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    QImage scaled = base.scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+    QRect clip(0, 0, qMin(size, scaled.width()), qMin(size, scaled.height()));
+    clip.moveCenter(scaled.rect().center());
+    return new QImage(scaled.copy(clip));
+}
+
+QImage* ThumbnailerRunnable::createBaseImage(DocumentInfo *imgInfo, int size) {
+    if(imgInfo->type() == STATIC) {
+        QImage *preview = createFromEmbeddedPreview(imgInfo, size);
+        if(preview)
+            return preview;
+    }
+    // no need to spawn mpv for every file if the player library can do it in-process
+    if(imgInfo->type() == VIDEO && frameGrabbers && frameGrabbers->isAvailable())
+        return createFromVideoFrame(imgInfo, size);
     QImageReader reader;
     QString filePath;
     if(imgInfo->type() == VIDEO) {
@@ -85,23 +172,18 @@ QImage* ThumbnailerRunnable::createThumbnailImage(DocumentInfo *imgInfo, int siz
     } else {
         filePath = imgInfo->filePath();
     }
-    reader.setFileName(filePath);
+    CancellableFile file(filePath, cancelled.get());
+    file.open(QIODevice::ReadOnly);
+    reader.setDevice(&file);
     reader.setFormat(imgInfo->format().toStdString().c_str());
-    Qt::AspectRatioMode method = squared?
-                (Qt::KeepAspectRatioByExpanding):(Qt::KeepAspectRatio);
-    QSize scaledSize = reader.size().scaled(size, size, method);
-    reader.setScaledSize(scaledSize);
-    if(squared) {
-        QRect clip(0, 0, size, size);
-        QRect scaledRect(QPoint(0,0), scaledSize);
-        clip.moveCenter(scaledRect.center());
-        reader.setScaledClipRect(clip);
-    }
-    if(reader.supportsOption(QImageIOHandler::Size))
+    if(reader.supportsOption(QImageIOHandler::Size)) {
         originalSize = reader.size();
+        reader.setScaledSize(baseSizeFor(originalSize, size));
+    }
     QImage *scaled = new QImage(reader.read());
     // force reader to close file so it can be deleted later
-    reader.setFileName("");
+    reader.setDevice(nullptr);
+    file.close();
     // remove temporary file in video case
     if(imgInfo->type() == VIDEO) {
         QFile tmpFile(filePath);
@@ -110,5 +192,57 @@ QImage* ThumbnailerRunnable::createThumbnailImage(DocumentInfo *imgInfo, int siz
     return scaled;
 }
 
+// Camera jpegs and raws usually embed a preview; use it when it is large enough.
+// Returns nullptr if there is none, so the caller falls back to decoding the file.
+QImage* ThumbnailerRunnable::createFromEmbeddedPreview(DocumentInfo *imgInfo, int size) {
+    QImageReader original(imgInfo->filePath(), imgInfo->format().toStdString().c_str());
+    QSize fullSize = original.size();
+    // raws without a qt plugin
+    if(!fullSize.isValid())
+        fullSize = imgInfo->metadataImageSize();
+    bool knownSize = fullSize.isValid();
+    // unknown size: any preview that covers the thumbnail will do
+    QSize minSize = knownSize ? baseSizeFor(fullSize, size) : QSize(size, size);
+    // small enough to just decode
+    if(knownSize && minSize == fullSize)
+        return nullptr;
+    QByteArray data = imgInfo->embeddedPreview(minSize);
+    if(data.isEmpty())
+        return nullptr;
+    QBuffer buffer(&data);
+    QImageReader reader(&buffer);
+    QSize previewSize = reader.size();
+    if(!previewSize.isValid())
+        return nullptr;
+    if(knownSize) {
+        // small exif thumbnails are often letterboxed to 4:3
+        double fullRatio = static_cast<double>(fullSize.width()) / fullSize.height();
+        double previewRatio = static_cast<double>(previewSize.width()) / previewSize.height();
+        if(qAbs(previewRatio - fullRatio) > fullRatio * 0.02)
+            return nullptr;
+    } else {
+        // best guess, the largest previews match the sensor's aspect
+        fullSize = previewSize;
+    }
+    reader.setScaledSize(baseSizeFor(fullSize, size));
+    QImage *thumb = new QImage(reader.read());
+    if(thumb->isNull()) {
+        delete thumb;
+        return nullptr;
+    }
+    originalSize = fullSize;
+    return thumb;
+}
+
+QImage* ThumbnailerRunnable::createFromVideoFrame(DocumentInfo *imgInfo, int size) {
+    QImage frame;
+    if(!frameGrabbers->grab(imgInfo->filePath(), 0.3, size, frame, originalSize))
+        return new QImage();
+    QSize scaledSize = baseSizeFor(originalSize, size);
+    if(frame.size() != scaledSize)
+        frame = frame.scaled(scaledSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    return new QImage(frame);
+}
+
 ThumbnailerRunnable::~ThumbnailerRunnable() {
 }
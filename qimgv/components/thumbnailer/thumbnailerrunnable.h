@@ -4,32 +4,50 @@
 #include <QProcess>
 #include <QThread>
 #include <QCryptographicHash>
+#include <QFileInfo>
 #include <ctime>
 #include "sourcecontainers/thumbnail.h"
 #include "components/cache/thumbnailcache.h"
+#include "components/thumbnailer/framegrabberpool.h"
 #include "utils/imagefactory.h"
+#include "utils/cancellablefile.h"
 #include "settings.h"
 #include <memory>
+#include <atomic>
 #include <QImageWriter>
+#include <QBuffer>
 
 class ThumbnailerRunnable : public QObject, public QRunnable
 {
     Q_OBJECT
 public:
-    ThumbnailerRunnable(ThumbnailCache* _cache, QString _path, int _size, bool _squared, bool _forceGenerate);
+    ThumbnailerRunnable(ThumbnailCache* _cache, FrameGrabberPool *_frameGrabbers, QString _path, int _size, bool _squared, bool _forceGenerate,
+                        std::shared_ptr<const std::atomic_bool> _cancelled = nullptr);
     ~ThumbnailerRunnable();
     void run();
+    // only fill the disk cache, at idle cpu & io priority; taskEnd gets no thumbnail
+    void setStoreOnly(bool mode);
 
 private:
     QString generateIdString();
-    QImage* createThumbnailImage(DocumentInfo *img, int size, bool squared);
+    static bool canDerive(const QImage &base, int size);
+    static QSize baseSizeFor(QSize fullSize, int size);
+    static QImage* deriveThumbnail(const QImage &base, int size, bool squared);
+    QImage* createBaseImage(DocumentInfo *img, int size);
+    QImage* createFromEmbeddedPreview(DocumentInfo *imgInfo, int size);
+    QImage* createFromVideoFrame(DocumentInfo *imgInfo, int size);
+    // long side limit for the stored image, relative to its size
+    static const int MAX_BASE_ASPECT = 4;
     QString path;
     int size;
-    bool squared, forceGenerate;
+    bool squared, forceGenerate, storeOnly;
     ThumbnailCache* thumbnailCache;
+    FrameGrabberPool *frameGrabbers;
     QSize originalSize;
+    std::shared_ptr<const std::atomic_bool> cancelled;
+    bool isCancelled() const;
 
 signals:
-    void taskStart(QString, int);
+    // thumbnail is null if the task was cancelled
     void taskEnd(std::shared_ptr<Thumbnail>, QString);
 };
@@ -7,7 +7,7 @@
 
 #include "core.h"
 
-Core::Core() : QObject(), infiniteScrolling(false), mDrag(nullptr) {
+Core::Core() : QObject(), infiniteScrolling(false), mDrag(nullptr), lastScalingFilter(FILTER_BILINEAR) {
 #ifdef __GLIBC__
     // default value of 128k causes memory fragmentation issues
     // finding this took 3 days of my life
@@ -32,6 +32,8 @@ Core::Core() : QObject(), infiniteScrolling(false), mDrag(nullptr) {
 
 void Core::readSettings() {
     infiniteScrolling = settings->infiniteScrolling();
+    // results may depend on settings (smooth upscaling etc)
+    scaledCache.clear();
     if(settings->shuffleEnabled())
         syncRandomizer();
 }
@@ -53,6 +55,7 @@ void Core::initGui() {
 
 void Core::attachModel(DirectoryModel *_model) {
     model.reset(_model);
+    model->setRandomizer(&randomizer);
     presenter.setModel(model);
     if(settings->shuffleEnabled())
         syncRandomizer();
@@ -82,14 +85,16 @@ void Core::connectComponents() {
 
     connect(mw, &MW::scalingRequested, this, &Core::scalingRequest);
     connect(model->scaler, &Scaler::scalingFinished, this, &Core::onScalingFinished);
+    connect(model->scaler, &Scaler::scalingPreview, this, &Core::onScalingPreview);
 
     connect(model.get(), &DirectoryModel::fileAdded,      this, &Core::onFileAdded);
     connect(model.get(), &DirectoryModel::fileRemoved,    this, &Core::onFileRemoved);
-    connect(model.get(), &DirectoryModel::fileRenamed,    this, &Core::onFileRenamed);
+    connect(model.get(), &DirectoryModel::filesChanged,   this, &Core::onFilesChanged);
     connect(model.get(), &DirectoryModel::fileModified,   this, &Core::onFileModified);
     connect(model.get(), &DirectoryModel::loaded,         this, &Core::onModelLoaded);
     connect(model.get(), &DirectoryModel::itemReady,      this, &Core::onModelItemReady);
     connect(model.get(), &DirectoryModel::itemUpdated,    this, &Core::onModelItemUpdated);
+    connect(model.get(), &DirectoryModel::fullResolutionReady, this, &Core::onFullResolutionReady);
     connect(model.get(), &DirectoryModel::indexChanged,   this, &Core::updateInfoString);
     connect(model.get(), &DirectoryModel::sortingChanged, this, &Core::updateInfoString);
 }
@@ -381,7 +386,11 @@ void Core::onFileRemoved(QString /*fileName*/, int /*index*/) {
     updateInfoString();
 }
 
-void Core::onFileRenamed(QString /*from*/, int /*indexFrom*/, QString /*to*/, int /*indexTo*/) {
+void Core::onFilesChanged(const DirectoryChanges &/*changes*/) {
+    if(model->isEmpty()) {
+        mw->closeImage();
+    }
+    updateInfoString();
 }
 
 void Core::onFileAdded(QString fileName) {
@@ -483,7 +492,7 @@ void Core::resize(QSize size) {
     if(img && img->type() == STATIC) {
         auto imgStatic = dynamic_cast<ImageStatic *>(img.get());
         imgStatic->setEditedImage(std::unique_ptr<const QImage>(
-                    ImageLib::scaled(imgStatic->getImage(), size, 1)));
+                    ImageLib::scaled(imgStatic->getImage(), size, FILTER_LANCZOS)));
         model->updateItem(this->selectedFileName(), img);
         if(mw->currentViewMode() == MODE_FOLDERVIEW)
             img->save();
@@ -633,19 +642,46 @@ void Core::runScript(const QString &scriptName) {
 }
 
 void Core::scalingRequest(QSize size, ScalingFilter filter) {
+    lastScalingSize = size;
+    lastScalingFilter = filter;
     // filter out an unnecessary scale request at statup
     if(mw->isVisible() && state.hasActiveImage) {
-        std::shared_ptr<Image> forScale = model->getItem(model->currentFileName());
+        // not getItem(): we don't want to wait for a full resolution load here
+        std::shared_ptr<Image> forScale = model->itemAt(model->currentIndex());
         if(forScale) {
+            // zoomed in past what we have decoded; scale this one for now
+            if(forScale->isReduced() && size.width() > forScale->getImage()->width())
+                model->loadFullResolution(model->currentFileName());
             QString path = model->absolutePath() + "/" + model->currentFileName();
-            model->scaler->requestScaled(ScalerRequest(forScale, size, path, filter));
+            ScalerRequest req(forScale, size, path, filter);
+            QPixmap cached;
+            if(scaledCache.get(req, cached)) {
+                mw->onScalingFinished(std::unique_ptr<QPixmap>(new QPixmap(cached)));
+                return;
+            }
+            model->scaler->requestScaled(req);
         }
     }
 }
 
+void Core::onFullResolutionReady(QString fileName) {
+    if(fileName == model->currentFileName() && mw->currentViewMode() == MODE_DOCUMENT)
+        scalingRequest(lastScalingSize, lastScalingFilter);
+}
+
 // TODO: don't use connect? otherwise there is no point using unique_ptr
 void Core::onScalingFinished(QPixmap *scaled, ScalerRequest req) {
     if(state.hasActiveImage /* TODO: a better fix > */ && req.string == model->currentFilePath()) {
+        scaledCache.insert(req, *scaled);
+        mw->onScalingFinished(std::unique_ptr<QPixmap>(scaled));
+    } else {
+        delete scaled;
+    }
+}
+
+// low quality stand-in for a slow request; not cached, the final result follows
+void Core::onScalingPreview(QPixmap *scaled, ScalerRequest req) {
+    if(state.hasActiveImage && req.string == model->currentFilePath()) {
         mw->onScalingFinished(std::unique_ptr<QPixmap>(scaled));
     } else {
         delete scaled;
@@ -774,6 +810,7 @@ void Core::onModelItemReady(std::shared_ptr<Image> img) {
 }
 
 void Core::onModelItemUpdated(QString fileName) {
+    scaledCache.remove(model->fullPath(fileName));
     if(mw->currentViewMode() == MODE_DOCUMENT) {
         guiDisplayImage(model->getItem(fileName));
         updateInfoString();
@@ -792,7 +829,7 @@ void Core::guiSetImage(std::shared_ptr<Image> img) {
     }
     DocumentType type = img->type();
     if(type == STATIC) {
-        mw->setImage(img->getPixmap());
+        mw->setImage(img->getPixmap(), img->size());
     } else if(type == ANIMATED) {
         auto animated = dynamic_cast<ImageAnimated *>(img.get());
         mw->setAnimation(animated->getMovie());
@@ -817,7 +854,7 @@ void Core::updateInfoString() {
     qint64 fileSize = 0;
 
     if(model->isLoaded(model->currentFileName())) {
-        auto img = model->getItem(model->currentFileName());
+        auto img = model->itemAt(model->currentIndex());
         imageSize = img->size();
         fileSize  = img->fileSize();
     }
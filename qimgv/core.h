@@ -12,6 +12,7 @@
 #include "settings.h"
 #include "components/directorymodel.h"
 #include "components/directorypresenter.h"
+#include "components/cache/scaledcache.h"
 #include "components/scriptmanager/scriptmanager.h"
 #include "gui/mainwindow.h"
 #include "utils/randomizer.h"
@@ -66,6 +67,10 @@ private:
     Randomizer randomizer;
     void syncRandomizer();
 
+    QSize lastScalingSize;
+    ScalingFilter lastScalingFilter;
+    ScaledCache scaledCache;
+
     void attachModel(DirectoryModel *_model);
     QString selectedFileName();
     void guiSetImage(std::shared_ptr<Image> img);
@@ -82,12 +87,14 @@ private slots:
     void rotateRight();
     void close();
     void scalingRequest(QSize, ScalingFilter);
+    void onScalingPreview(QPixmap *scaled, ScalerRequest req);
     void onScalingFinished(QPixmap* scaled, ScalerRequest req);
+    void onFullResolutionReady(QString fileName);
     void moveFile(QString destDirectory);
     void copyFile(QString destDirectory);
     void removeFile(QString fileName, bool trash);
     void onFileRemoved(QString fileName, int index);
-    void onFileRenamed(QString from, int indexFrom, QString to, int indexTo);
+    void onFilesChanged(const DirectoryChanges &changes);
     void onFileAdded(QString fileName);
     void onFileModified(QString fileName);
     void showResizeDialog();
@@ -7,11 +7,14 @@ ThumbnailView::ThumbnailView(ThumbnailViewOrientation orient, QWidget *parent)
       mSelectedIndex(-1),
       mDrawScrollbarIndicator(true),
       mCropThumbnails(false),
+      mItemCount(0),
       scrollTimeLine(nullptr),
       mThumbnailSize(120)
 {
     setAccessibleName("thumbnailView");
     this->setMouseTracking(true);
+    // items move on every scroll, the index would just be rebuilt all the time
+    scene.setItemIndexMethod(QGraphicsScene::NoIndex);
     this->setScene(&scene);
     setViewportUpdateMode(QGraphicsView::SmartViewportUpdate);
     this->setOptimizationFlag(QGraphicsView::DontAdjustForAntialiasing, true);
@@ -90,13 +93,13 @@ void ThumbnailView::selectIndex(int index) {
     if(!checkRange(index))
         return;
 
-    if(checkRange(mSelectedIndex))
-        thumbnails.at(mSelectedIndex)->setHighlighted(false);
+    if(thumbnails.contains(mSelectedIndex))
+        thumbnails.value(mSelectedIndex)->setHighlighted(false);
 
     mSelectedIndex = index;
 
-    ThumbnailWidget *thumb = thumbnails.at(mSelectedIndex);
-    thumb->setHighlighted(true);
+    if(thumbnails.contains(mSelectedIndex))
+        thumbnails.value(mSelectedIndex)->setHighlighted(true);
     updateScrollbarIndicator();
 }
 
@@ -105,13 +108,15 @@ int ThumbnailView::selectedIndex() {
 }
 
 int ThumbnailView::itemCount() {
-    return thumbnails.count();
+    return mItemCount;
 }
 
 void ThumbnailView::showEvent(QShowEvent *event) {
     QGraphicsView::showEvent(event);
     // ensure we are properly resized
     qApp->processEvents();
+    updateLayout();
+    fitSceneToContents();
     updateScrollbarIndicator();
     ensureSelectedItemVisible();
     loadVisibleThumbnails();
@@ -119,74 +124,181 @@ void ThumbnailView::showEvent(QShowEvent *event) {
 
 void ThumbnailView::populate(int count) {
     if(count >= 0) {
-        // reuse existing items
-        if(count == thumbnails.count()) {
-            QList<ThumbnailWidget*>::iterator i;
-            for (i = thumbnails.begin(); i != thumbnails.end(); ++i) {
-                (*i)->reset();
-            }
-        } else {
-            removeAll();
-            for(int i = 0; i < count; i++) {
-                ThumbnailWidget *widget = createThumbnailWidget();
-                widget->setThumbnailSize(mThumbnailSize);
-                thumbnails.append(widget);
-                addItemToLayout(widget, i);
-            }
-        }
+        recycleAll();
+        mItemCount = count;
     }
     mSelectedIndex = -1;
     updateLayout();
     fitSceneToContents();
     resetViewport();
+    updateVisibleItems();
 }
 
 void ThumbnailView::addItem() {
-    insertItem(thumbnails.count());
+    insertItem(mItemCount);
 }
 
 // insert at index
 void ThumbnailView::insertItem(int index) {
+    if(index < 0 || index > mItemCount)
+        return;
     if(index <= mSelectedIndex) {
         mSelectedIndex++;
     }
-    ThumbnailWidget *widget = createThumbnailWidget();
-    thumbnails.insert(index, widget);
-    addItemToLayout(widget, index);
+    shiftItems(index, 1);
+    mItemCount++;
     updateLayout();
     fitSceneToContents();
+    updateVisibleItems();
     updateScrollbarIndicator();
     loadVisibleThumbnails();
 }
 
 void ThumbnailView::removeItem(int index) {
     if(checkRange(index)) {
-        removeItemFromLayout(index);
-        delete thumbnails.takeAt(index);
+        if(thumbnails.contains(index))
+            recycleWidget(thumbnails.take(index));
+        shiftItems(index + 1, -1);
+        mItemCount--;
+        updateLayout();
         fitSceneToContents();
         if(index < mSelectedIndex) {
-            selectIndex(mSelectedIndex - 1);
+            mSelectedIndex--;
         } else if(index == mSelectedIndex) {
-            if(mSelectedIndex >= thumbnails.count())
-                selectIndex(thumbnails.count() - 1);
-            else
-                selectIndex(mSelectedIndex);
+            // highlight whatever took its place
+            mSelectedIndex = -1;
+            selectIndex(qMin(index, mItemCount - 1));
         }
+        updateVisibleItems();
         updateScrollbarIndicator();
         loadVisibleThumbnails();
     }
 }
 
+// same as removeItem() & insertItem() one by one, but with a single relayout
+void ThumbnailView::applyChanges(QList<int> removed, QList<int> added) {
+    int selected = mSelectedIndex;
+    for(int index : removed) {
+        if(!checkRange(index))
+            continue;
+        if(thumbnails.contains(index))
+            recycleWidget(thumbnails.take(index));
+        shiftItems(index + 1, -1);
+        mItemCount--;
+        if(index < selected)
+            selected--;
+    }
+    for(int index : added) {
+        if(index < 0 || index > mItemCount)
+            continue;
+        if(index <= selected)
+            selected++;
+        shiftItems(index, 1);
+        mItemCount++;
+    }
+    updateLayout();
+    fitSceneToContents();
+    if(mSelectedIndex != -1) {
+        mSelectedIndex = -1;
+        selectIndex(qMin(selected, mItemCount - 1));
+    }
+    updateVisibleItems();
+    updateScrollbarIndicator();
+    loadVisibleThumbnails();
+}
+
 void ThumbnailView::reloadItem(int index) {
-    if(!checkRange(index))
-        return;
-    auto thumb = thumbnails.at(index);
-    if(thumb->isLoaded) {
+    ThumbnailWidget *thumb = thumbnails.value(index);
+    if(thumb && thumb->isLoaded) {
         thumb->unsetThumbnail();
         emit thumbnailsRequested(QList<int>() << index, static_cast<int>(qApp->devicePixelRatio() * mThumbnailSize), mCropThumbnails, true);
     }
 }
 
+// binds widgets to the items around the viewport, recycles the rest
+void ThumbnailView::updateVisibleItems() {
+    QRectF visibleRect = mapToScene(viewport()->geometry()).boundingRect();
+    visibleRect.adjust(-offscreenPreloadArea, -offscreenPreloadArea,
+                       offscreenPreloadArea, offscreenPreloadArea);
+    int first, last;
+    itemRange(visibleRect, first, last);
+    for(auto i = thumbnails.begin(); i != thumbnails.end();) {
+        if(i.key() < first || i.key() > last) {
+            recycleWidget(i.value());
+            i = thumbnails.erase(i);
+        } else {
+            i.value()->setPos(itemRect(i.key()).topLeft());
+            ++i;
+        }
+    }
+    for(int i = first; i <= last; i++) {
+        if(thumbnails.contains(i))
+            continue;
+        ThumbnailWidget *widget = takeWidget();
+        widget->reset();
+        widget->setHighlighted(i == mSelectedIndex);
+        widget->setPos(itemRect(i).topLeft());
+        widget->show();
+        thumbnails.insert(i, widget);
+    }
+}
+
+ThumbnailWidget *ThumbnailView::takeWidget() {
+    ThumbnailWidget *widget;
+    if(recycledItems.isEmpty()) {
+        widget = createThumbnailWidget();
+        widget->hide();
+        scene.addItem(widget);
+    } else {
+        widget = recycledItems.takeLast();
+    }
+    widget->setThumbnailSize(mThumbnailSize);
+    return widget;
+}
+
+void ThumbnailView::recycleWidget(ThumbnailWidget *widget) {
+    widget->unsetThumbnail();
+    widget->hide();
+    recycledItems.append(widget);
+}
+
+void ThumbnailView::recycleAll() {
+    for(auto widget : thumbnails)
+        recycleWidget(widget);
+    thumbnails.clear();
+}
+
+// moves widgets of the items starting at index by delta
+void ThumbnailView::shiftItems(int index, int delta) {
+    QHash<int, ThumbnailWidget*> shifted;
+    shifted.reserve(thumbnails.count());
+    for(auto i = thumbnails.constBegin(); i != thumbnails.constEnd(); ++i)
+        shifted.insert(i.key() >= index ? i.key() + delta : i.key(), i.value());
+    thumbnails.swap(shifted);
+}
+
+// measured on a spare widget, so that item geometry can be computed without one
+void ThumbnailView::updateItemSize() {
+    ThumbnailWidget *widget = takeWidget();
+    mItemSize = widget->boundingRect().size();
+    recycledItems.append(widget);
+}
+
+QList<ThumbnailWidget*> ThumbnailView::allWidgets() const {
+    return thumbnails.values() + recycledItems;
+}
+
+int ThumbnailView::indexAt(const QPoint &pos) {
+    QPointF scenePos = mapToScene(pos);
+    int first, last;
+    itemRange(QRectF(scenePos, QSizeF(1, 1)), first, last);
+    for(int i = first; i <= last; i++) {
+        if(itemRect(i).contains(scenePos))
+            return i;
+    }
+    return -1;
+}
+
 void ThumbnailView::setCropThumbnails(bool mode) {
     if(mode != mCropThumbnails) {
         unloadAllThumbnails();
@@ -200,44 +312,37 @@ void ThumbnailView::setDrawScrollbarIndicator(bool mode) {
 }
 
 void ThumbnailView::setThumbnail(int pos, std::shared_ptr<Thumbnail> thumb) {
-    if(thumb && thumb->size() == floor(mThumbnailSize * qApp->devicePixelRatio()) && checkRange(pos)) {
-        thumbnails.at(pos)->setThumbnail(thumb);
+    // items scrolled away meanwhile are dropped
+    if(thumb && thumb->size() == floor(mThumbnailSize * qApp->devicePixelRatio()) && thumbnails.contains(pos)) {
+        thumbnails.value(pos)->setThumbnail(thumb);
     }
 }
 
 void ThumbnailView::unloadAllThumbnails() {
-    for(int i = 0; i < thumbnails.count(); i++) {
-        thumbnails.at(i)->unsetThumbnail();
-    }
+    for(auto widget : thumbnails)
+        widget->unsetThumbnail();
 }
 
 void ThumbnailView::loadVisibleThumbnails() {
     loadTimer.stop();
     if(isVisible() && !blockThumbnailLoading) {
-        QRectF visibleRect = mapToScene(viewport()->geometry()).boundingRect();
-        // grow rectangle to cover nearby offscreen items
-        visibleRect.adjust(-offscreenPreloadArea, -offscreenPreloadArea,
-                           offscreenPreloadArea, offscreenPreloadArea);
-        QList<QGraphicsItem *>visibleItems = scene.items(visibleRect,
-                                                         Qt::IntersectsItemShape,
-                                                         Qt::AscendingOrder);
+        // offscreen items lose their widget and thumbnail here
+        updateVisibleItems();
         // load new previews
         QList<int> loadList;
-        for(int i = 0; i < visibleItems.count(); i++) {
-            ThumbnailWidget* widget = qgraphicsitem_cast<ThumbnailWidget*>(visibleItems.at(i));
-            if(!widget->isLoaded) {
-                loadList.append(thumbnails.indexOf(widget));
-            }
-        }
-        if(loadList.count()) {
-            emit thumbnailsRequested(loadList, static_cast<int>(qApp->devicePixelRatio() * mThumbnailSize), mCropThumbnails, false);
-        }
-        // unload offscreen
-        for(int i = 0; i < thumbnails.count(); i++) {
-            if(!visibleItems.contains(thumbnails.at(i))) {
-                thumbnails.at(i)->unsetThumbnail();
-            }
+        for(auto i = thumbnails.constBegin(); i != thumbnails.constEnd(); ++i) {
+            if(!i.value()->isLoaded)
+                loadList.append(i.key());
         }
+        // closest to the viewport center go first
+        QPointF center = mapToScene(viewport()->rect().center());
+        std::sort(loadList.begin(), loadList.end());
+        std::stable_sort(loadList.begin(), loadList.end(), [&](int a, int b) {
+            return (itemRect(a).center() - center).manhattanLength() <
+                   (itemRect(b).center() - center).manhattanLength();
+        });
+        // sent even when empty so that the thumbnailer can drop work for items we scrolled past
+        emit thumbnailsRequested(loadList, static_cast<int>(qApp->devicePixelRatio() * mThumbnailSize), mCropThumbnails, false);
     }
 }
 
@@ -291,7 +396,7 @@ bool ThumbnailView::atSceneEnd() {
 }
 
 bool ThumbnailView::checkRange(int pos) {
-    return pos >= 0 && pos < thumbnails.count();
+    return pos >= 0 && pos < mItemCount;
 }
 
 void ThumbnailView::updateLayout() {
@@ -300,7 +405,10 @@ void ThumbnailView::updateLayout() {
 
 // fit scene to it's contents size
 void ThumbnailView::fitSceneToContents() {
-    scene.setSceneRect(scene.itemsBoundingRect());
+    if(mItemCount)
+        scene.setSceneRect(itemRect(0).united(itemRect(mItemCount - 1)));
+    else
+        scene.setSceneRect(QRectF(QPointF(0, 0), viewport()->size()));
 }
 
 //################### scrolling ######################
@@ -385,9 +493,9 @@ void ThumbnailView::scrollSmooth(int angleDelta) {
 
 void ThumbnailView::mousePressEvent(QMouseEvent *event) {
     if(event->button() == Qt::LeftButton) {
-        ThumbnailWidget *item = dynamic_cast<ThumbnailWidget*>(itemAt(event->pos()));
-        if(item) {
-            emit thumbnailPressed(thumbnails.indexOf(item));
+        int index = indexAt(event->pos());
+        if(index != -1) {
+            emit thumbnailPressed(index);
             return;
         }
     }
@@ -2,10 +2,10 @@
 
 /* This class manages QGraphicsScene, ThumbnailWidget list,
  * scrolling, requesting and setting thumbnails.
- * It doesn't do actual positioning of thumbnails within the scene.
- * (But maybe it should?)
+ * The view is virtualized: widgets exist only for items near the viewport.
+ * They are taken from a pool and rebound to other indices on scroll.
  *
- * Usage: subclass, implement layout-related stuff
+ * Usage: subclass, implement itemRect() & itemRange()
  */
 
 #include <QGraphicsView>
@@ -17,6 +17,8 @@
 #include <QTimeLine>
 #include <QTimer>
 #include <QElapsedTimer>
+#include <QHash>
+#include <algorithm>
 #include "gui/customwidgets/thumbnailwidget.h"
 #include "gui/idirectoryview.h"
 
@@ -47,7 +49,9 @@ public slots:
     virtual void setThumbnail(int pos, std::shared_ptr<Thumbnail> thumb) Q_DECL_OVERRIDE;
     virtual void insertItem(int index) Q_DECL_OVERRIDE;
     virtual void removeItem(int index) Q_DECL_OVERRIDE;
+    virtual void applyChanges(QList<int> removed, QList<int> added) Q_DECL_OVERRIDE;
     virtual void reloadItem(int index) Q_DECL_OVERRIDE;
+    void updateVisibleItems();
 
 signals:
     void thumbnailPressed(int) Q_DECL_OVERRIDE;
@@ -67,10 +71,21 @@ private:
 
     bool mCropThumbnails;
 
+    int mItemCount;
+    // unused widgets, hidden
+    QList<ThumbnailWidget*> recycledItems;
+
     void createScrollTimeLine();
+    ThumbnailWidget *takeWidget();
+    void recycleWidget(ThumbnailWidget *widget);
+    void recycleAll();
+    void shiftItems(int index, int delta);
 protected:
     QGraphicsScene scene;
-    QList<ThumbnailWidget*> thumbnails;
+    // widgets of items near the viewport, by index
+    QHash<int, ThumbnailWidget*> thumbnails;
+    // all items are the same size
+    QSizeF mItemSize;
     QScrollBar *scrollBar;
     QTimeLine *scrollTimeLine;
     QPointF viewportCenter;
@@ -93,10 +108,14 @@ protected:
     bool checkRange(int pos);
 
     virtual ThumbnailWidget *createThumbnailWidget() = 0;
-    virtual void addItemToLayout(ThumbnailWidget* widget, int pos) = 0;
-    virtual void removeItemFromLayout(int pos) = 0;
-    virtual void removeAll() = 0;
+    // scene rect of an item, computed from the index
+    virtual QRectF itemRect(int index) = 0;
+    // first & last item that can intersect the rect, last < first if none
+    virtual void itemRange(const QRectF &rect, int &first, int &last) = 0;
     virtual void updateLayout();
+    void updateItemSize();
+    QList<ThumbnailWidget*> allWidgets() const;
+    int indexAt(const QPoint &pos);
     virtual void fitSceneToContents();
     virtual void ensureSelectedItemVisible() = 0;
     virtual void updateScrollbarIndicator() = 0;
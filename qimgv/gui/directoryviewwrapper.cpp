@@ -42,6 +42,10 @@ void DirectoryViewWrapper::removeItem(int index) {
     view->removeItem(index);
 }
 
+void DirectoryViewWrapper::applyChanges(QList<int> removed, QList<int> added) {
+    view->applyChanges(removed, added);
+}
+
 void DirectoryViewWrapper::reloadItem(int index) {
     view->reloadItem(index);
 }
@@ -19,6 +19,7 @@ public slots:
     void setDirectoryPath(QString path);
     void insertItem(int index);
     void removeItem(int index);
+    void applyChanges(QList<int> removed, QList<int> added);
     void reloadItem(int index);
 
 signals:
@@ -5,7 +5,9 @@
 FolderGridView::FolderGridView(QWidget *parent)
     : ThumbnailView(THUMBNAILVIEW_VERTICAL, parent),
       shiftedCol(-1),
-      mShowLabels(false)
+      mShowLabels(false),
+      mColumns(1),
+      centerOffset(0)
 {
     offscreenPreloadArea = 2300;
     this->viewport()->setAttribute(Qt::WA_OpaquePaintEvent, true);
@@ -24,10 +26,9 @@ void FolderGridView::onThumbnailPressed() {
 }
 
 void FolderGridView::updateScrollbarIndicator() {
-    if(!thumbnails.count() || selectedIndex() == -1)
+    if(!itemCount() || selectedIndex() == -1)
         return;
-    ThumbnailWidget *thumb = thumbnails.at(selectedIndex());
-    qreal itemCenter = (thumb->pos().y() + (thumb->height() / 2)) / scene.height();
+    qreal itemCenter = itemRect(selectedIndex()).center().y() / scene.height();
     indicator = QRect(2, scrollBar->height() * itemCenter - indicatorSize, scrollBar->width() - 4, indicatorSize);
 }
 
@@ -45,11 +46,11 @@ void FolderGridView::hide() {
 
 void FolderGridView::setShowLabels(bool mode) {
     mShowLabels = mode;
-    for(int i = 0; i < thumbnails.count(); i++) {
-        thumbnails.at(i)->setDrawLabel(mShowLabels);
-    }
+    for(auto widget : allWidgets())
+        widget->setDrawLabel(mShowLabels);
     updateLayout();
-    fitToContents();
+    fitSceneToContents();
+    updateVisibleItems();
     ensureSelectedItemVisible();
     emit showLabelsChanged(mShowLabels);
 }
@@ -57,17 +58,16 @@ void FolderGridView::setShowLabels(bool mode) {
 void FolderGridView::ensureSelectedItemVisible() {
     if(!checkRange(selectedIndex()))
         return;
-    ThumbnailWidget *thumb = thumbnails.at(selectedIndex());
-    ensureVisible(thumb, 0, 0);
+    ensureVisible(itemRect(selectedIndex()), 0, 0);
 }
 
 void FolderGridView::selectAbove() {
-    if(!thumbnails.count() || flowLayout->sameRow(0, selectedIndex()))
+    if(!itemCount() || sameRow(0, selectedIndex()))
         return;
     int newIndex;
-    newIndex = flowLayout->itemAbove(selectedIndex());
+    newIndex = itemAbove(selectedIndex());
     if(shiftedCol >= 0) {
-        int diff = shiftedCol - flowLayout->columnOf(selectedIndex());
+        int diff = shiftedCol - columnOf(selectedIndex());
         newIndex += diff;
         shiftedCol = -1;
     }
@@ -78,31 +78,31 @@ void FolderGridView::selectAbove() {
 }
 
 void FolderGridView::selectBelow() {
-    if(!thumbnails.count() || flowLayout->sameRow(selectedIndex(), thumbnails.count() - 1))
+    if(!itemCount() || sameRow(selectedIndex(), itemCount() - 1))
         return;
     shiftedCol = -1;
-    int newIndex = flowLayout->itemBelow(selectedIndex());
+    int newIndex = itemBelow(selectedIndex());
     if(!checkRange(newIndex))
-        newIndex = thumbnails.count() - 1;
-    if(flowLayout->columnOf(newIndex) != flowLayout->columnOf(selectedIndex()))
-        shiftedCol = flowLayout->columnOf(selectedIndex());
+        newIndex = itemCount() - 1;
+    if(columnOf(newIndex) != columnOf(selectedIndex()))
+        shiftedCol = columnOf(selectedIndex());
     selectIndex(newIndex);
     scrollToCurrent();
 }
 
 void FolderGridView::selectNext() {
-    if(!thumbnails.count() || selectedIndex() == thumbnails.count() - 1)
+    if(!itemCount() || selectedIndex() == itemCount() - 1)
         return;
     shiftedCol = -1;
     int newIndex = selectedIndex() + 1;
     if(!checkRange(newIndex))
-        newIndex = thumbnails.count() - 1;
+        newIndex = itemCount() - 1;
     selectIndex(newIndex);
     scrollToCurrent();
 }
 
 void FolderGridView::selectPrev() {
-    if(!thumbnails.count() || selectedIndex() == 0)
+    if(!itemCount() || selectedIndex() == 0)
         return;
     shiftedCol = -1;
     int newIndex = selectedIndex() - 1;
@@ -113,18 +113,18 @@ void FolderGridView::selectPrev() {
 }
 
 void FolderGridView::pageUp() {
-    if(!thumbnails.count() || flowLayout->sameRow(0, selectedIndex()))
+    if(!itemCount() || sameRow(0, selectedIndex()))
         return;
     int newIndex = selectedIndex();
     int tmp;
     // 4 rows up
     for(int i = 0; i < 4; i++) {
-        tmp = flowLayout->itemAbove(newIndex);
+        tmp = itemAbove(newIndex);
         if(checkRange(tmp))
             newIndex = tmp;
     }
     if(shiftedCol >= 0) {
-        int diff = shiftedCol - flowLayout->columnOf(newIndex);
+        int diff = shiftedCol - columnOf(newIndex);
         newIndex += diff;
         shiftedCol = -1;
     }
@@ -133,25 +133,25 @@ void FolderGridView::pageUp() {
 }
 
 void FolderGridView::pageDown() {
-    if(!thumbnails.count() || flowLayout->sameRow(selectedIndex(), thumbnails.count() - 1))
+    if(!itemCount() || sameRow(selectedIndex(), itemCount() - 1))
         return;
     shiftedCol = -1;
     int newIndex = selectedIndex();
     int tmp;
     // 4 rows down
     for(int i = 0; i < 4; i++) {
-        tmp = flowLayout->itemBelow(newIndex);
+        tmp = itemBelow(newIndex);
         if(checkRange(tmp))
             newIndex = tmp;
     }
-    if(flowLayout->columnOf(newIndex) != flowLayout->columnOf(selectedIndex()))
-        shiftedCol = flowLayout->columnOf(selectedIndex());
+    if(columnOf(newIndex) != columnOf(selectedIndex()))
+        shiftedCol = columnOf(selectedIndex());
     selectIndex(newIndex);
     scrollToCurrent();
 }
 
 void FolderGridView::selectFirst() {
-    if(!thumbnails.count())
+    if(!itemCount())
         return;
     shiftedCol = -1;
     selectIndex(0);
@@ -159,10 +159,10 @@ void FolderGridView::selectFirst() {
 }
 
 void FolderGridView::selectLast() {
-    if(!thumbnails.count())
+    if(!itemCount())
         return;
     shiftedCol = -1;
-    selectIndex(thumbnails.count() - 1);
+    selectIndex(itemCount() - 1);
     scrollToCurrent();
 }
 
@@ -174,20 +174,18 @@ void FolderGridView::scrollToItem(int index) {
     if(!checkRange(index))
         return;
 
-    ThumbnailWidget *item = thumbnails.at(index);
-
     QRectF sceneRect = mapToScene(viewport()->rect()).boundingRect();
-    QRectF itemRect = item->mapRectToScene(item->rect());
+    QRectF rect = itemRect(index);
 
-    bool visible = sceneRect.contains(itemRect);
+    bool visible = sceneRect.contains(rect);
     if(!visible) {
         int delta = 0;
         // UP
-        if(itemRect.top() >= sceneRect.top())
-            delta = sceneRect.bottom() - itemRect.bottom();
+        if(rect.top() >= sceneRect.top())
+            delta = sceneRect.bottom() - rect.bottom();
         // DOWN
         else
-            delta = sceneRect.top() - itemRect.top();
+            delta = sceneRect.top() - rect.top();
         scrollSmooth(delta);
     }
 }
@@ -196,19 +194,13 @@ void FolderGridView::scrollToItem(int index) {
 void FolderGridView::focusOn(int index) {
     if(!checkRange(index))
         return;
-    ThumbnailWidget *thumb = thumbnails.at(index);
-    ensureVisible(thumb, 0, 0);
+    ensureVisible(itemRect(index), 0, 0);
     loadVisibleThumbnailsDelayed();
 }
 
 void FolderGridView::setupLayout() {
     this->setAlignment(Qt::AlignHCenter);
-
-    flowLayout = new FlowLayout();
-    flowLayout->setContentsMargins(12,0,12,0);
     setFrameShape(QFrame::NoFrame);
-    scene.addItem(&holderWidget);
-    holderWidget.setLayout(flowLayout);
 }
 
 ThumbnailWidget* FolderGridView::createThumbnailWidget() {
@@ -219,25 +211,66 @@ ThumbnailWidget* FolderGridView::createThumbnailWidget() {
     return widget;
 }
 
-void FolderGridView::addItemToLayout(ThumbnailWidget* widget, int pos) {
-    scene.addItem(widget);
-    flowLayout->insertItem(pos, widget);
-}
-
-void FolderGridView::removeItemFromLayout(int pos) {
-    flowLayout->removeAt(pos);
+QRectF FolderGridView::itemRect(int index) {
+    return QRectF(LAYOUT_MARGIN + centerOffset + (index % mColumns) * mItemSize.width(),
+                  (index / mColumns) * mItemSize.height(),
+                  mItemSize.width(), mItemSize.height());
 }
 
-void FolderGridView::removeAll() {
-    flowLayout->clear();
-    qDeleteAll(thumbnails);
-    thumbnails.clear();
+// whole rows
+void FolderGridView::itemRange(const QRectF &rect, int &first, int &last) {
+    if(!itemCount() || mItemSize.height() <= 0) {
+        first = 0;
+        last = -1;
+        return;
+    }
+    int firstRow = qMax(0, static_cast<int>(floor(rect.top() / mItemSize.height())));
+    int lastRow = static_cast<int>(floor(rect.bottom() / mItemSize.height()));
+    first = firstRow * mColumns;
+    last = qMin(itemCount() - 1, (lastRow + 1) * mColumns - 1);
 }
 
+// as many columns as fit, centered
 void FolderGridView::updateLayout() {
     shiftedCol = -1;
-    flowLayout->invalidate();
-    flowLayout->activate();
+    updateItemSize();
+    qreal rowWidth = width() - scrollBar->width() - LAYOUT_MARGIN * 2;
+    mColumns = qMax(1, static_cast<int>(rowWidth / mItemSize.width()));
+    centerOffset = 0;
+    if(itemCount() >= mColumns)
+        centerOffset = static_cast<int>(qMax<qreal>(0, rowWidth - mColumns * mItemSize.width()) / 2);
+}
+
+int FolderGridView::itemAbove(int index) {
+    if(!checkRange(index))
+        return -1;
+    int indexAbove = index - mColumns;
+    if(indexAbove >= 0)
+        return indexAbove;
+    else
+        return index;
+}
+
+int FolderGridView::itemBelow(int index) {
+    if(!checkRange(index))
+        return -1;
+    if(sameRow(index, itemCount() - 1))
+        return index;
+    int indexBelow = index + mColumns;
+    if(indexBelow < itemCount())
+        return indexBelow;
+    else
+        return itemCount() - 1;
+}
+
+int FolderGridView::columnOf(int index) {
+    if(!checkRange(index))
+        return -1;
+    return index % mColumns;
+}
+
+bool FolderGridView::sameRow(int one, int two) {
+    return (one / mColumns) == (two / mColumns);
 }
 
 void FolderGridView::keyPressEvent(QKeyEvent *event) {
@@ -294,27 +327,30 @@ void FolderGridView::zoomOut() {
 void FolderGridView::setThumbnailSize(int newSize) {
     newSize = clamp(newSize, THUMBNAIL_SIZE_MIN, THUMBNAIL_SIZE_MAX);
     mThumbnailSize = newSize;
-    for(int i = 0; i < thumbnails.count(); i++) {
-        thumbnails.at(i)->setThumbnailSize(newSize);
-    }
+    for(auto widget : allWidgets())
+        widget->setThumbnailSize(newSize);
     updateLayout();
-    fitToContents();
+    fitSceneToContents();
     if(checkRange(selectedIndex()))
-        ensureVisible(thumbnails.at(selectedIndex()), 0, 40);
+        ensureVisible(itemRect(selectedIndex()), 0, 40);
+    updateVisibleItems();
     emit thumbnailSizeChanged(mThumbnailSize);
     loadVisibleThumbnails();
 }
 
-void FolderGridView::fitToContents() {
-    holderWidget.setMinimumSize(size() - QSize(scrollBar->width(), 0));
-    holderWidget.setMaximumSize(size() - QSize(scrollBar->width(), 0));
-    fitSceneToContents();
+// full width, at least as tall as the view
+void FolderGridView::fitSceneToContents() {
+    int rows = (itemCount() + mColumns - 1) / mColumns;
+    scene.setSceneRect(0, 0, width() - scrollBar->width(),
+                       qMax(rows * mItemSize.height(), static_cast<qreal>(height())));
 }
 
 void FolderGridView::resizeEvent(QResizeEvent *event) {
     if(this->isVisible()) {
         ThumbnailView::resizeEvent(event);
-        fitToContents();
+        updateLayout();
+        fitSceneToContents();
+        updateVisibleItems();
         focusOn(selectedIndex());
         loadVisibleThumbnailsDelayed();
     }
@@ -1,10 +1,7 @@
 #pragma once
 
-#include <QGraphicsWidget>
-
 #include "gui/customwidgets/thumbnailview.h"
 #include "gui/folderview/thumbnailgridwidget.h"
-#include "gui/flowlayout.h"
 #include "components/actionmanager/actionmanager.h"
 #include "utils/stuff.h"
 
@@ -17,6 +14,7 @@ public:
     const int THUMBNAIL_SIZE_MIN = 100;  // px
     const int THUMBNAIL_SIZE_MAX = 400;  // these should be divisible by ZOOM_STEP
     const int ZOOM_STEP = 25;
+    const int LAYOUT_MARGIN = 12; // px, left & right
 
 public slots:
     void show();
@@ -33,10 +31,16 @@ public slots:
     void setShowLabels(bool mode);
 
 private:
-    FlowLayout *flowLayout;
-    QGraphicsWidget holderWidget;
     int shiftedCol;
     bool mShowLabels;
+    // grid, all items are the same size
+    int mColumns;
+    qreal centerOffset;
+
+    int itemAbove(int index);
+    int itemBelow(int index);
+    int columnOf(int index);
+    bool sameRow(int one, int two);
 
     void scrollToCurrent();
     void scrollToItem(int index);
@@ -49,14 +53,13 @@ private slots:
 protected:
     void resizeEvent(QResizeEvent *event);
     virtual void updateScrollbarIndicator();
-    void addItemToLayout(ThumbnailWidget *widget, int pos);
-    void removeItemFromLayout(int pos);
-    void removeAll();
     void setupLayout();
     ThumbnailWidget *createThumbnailWidget();
+    QRectF itemRect(int index);
+    void itemRange(const QRectF &rect, int &first, int &last);
     void updateLayout();
     void ensureSelectedItemVisible();
-    void fitToContents();
+    void fitSceneToContents();
 
     void keyPressEvent(QKeyEvent *event);
     void wheelEvent(QWheelEvent *event);
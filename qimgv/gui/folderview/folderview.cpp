@@ -148,6 +148,10 @@ void FolderView::removeItem(int index) {
     ui->thumbnailGrid->removeItem(index);
 }
 
+void FolderView::applyChanges(QList<int> removed, QList<int> added) {
+    ui->thumbnailGrid->applyChanges(removed, added);
+}
+
 void FolderView::reloadItem(int index) {
     ui->thumbnailGrid->reloadItem(index);
 }
@@ -31,6 +31,7 @@ public slots:
     virtual void setDirectoryPath(QString path) Q_DECL_OVERRIDE;
     virtual void insertItem(int index) Q_DECL_OVERRIDE;
     virtual void removeItem(int index) Q_DECL_OVERRIDE;
+    virtual void applyChanges(QList<int> removed, QList<int> added) Q_DECL_OVERRIDE;
     virtual void reloadItem(int index) Q_DECL_OVERRIDE;
     void addItem();
     void onFullscreenModeChanged(bool mode);
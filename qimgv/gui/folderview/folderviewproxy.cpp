@@ -108,6 +108,20 @@ void FolderViewProxy::removeItem(int index) {
     }
 }
 
+void FolderViewProxy::applyChanges(QList<int> removed, QList<int> added) {
+    if(folderView) {
+        folderView->applyChanges(removed, added);
+    } else {
+        for(int index : removed)
+            removeItem(index);
+        for(int index : added) {
+            stateBuf.itemCount++;
+            if(index <= stateBuf.selectedIndex)
+                stateBuf.selectedIndex++;
+        }
+    }
+}
+
 void FolderViewProxy::reloadItem(int index) {
     if(folderView)
         folderView->reloadItem(index);
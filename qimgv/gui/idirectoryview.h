@@ -16,6 +16,8 @@ public:
     virtual void setDirectoryPath(QString path) = 0;
     virtual void insertItem(int index) = 0;
     virtual void removeItem(int index) = 0;
+    // removed: old indices, descending; added: new indices, ascending
+    virtual void applyChanges(QList<int> removed, QList<int> added) = 0;
     virtual void reloadItem(int index) = 0;
 
 //signals
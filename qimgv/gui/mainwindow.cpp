@@ -202,8 +202,8 @@ void MW::closeImage() {
     viewerWidget->closeImage();
 }
 
-void MW::setImage(std::unique_ptr<QPixmap> pixmap) {
-    viewerWidget->showImage(std::move(pixmap));
+void MW::setImage(std::unique_ptr<QPixmap> pixmap, QSize sourceSize) {
+    viewerWidget->showImage(std::move(pixmap), sourceSize);
     updateCropPanelData();
 }
 
@@ -254,11 +254,15 @@ void MW::toggleRenameOverlay() {
         renameOverlay->hide();
 }
 
+// switches between nearest and the filter selected in settings
 void MW::toggleScalingFilter() {
-    if(viewerWidget->scalingFilter() == FILTER_BILINEAR)
+    ScalingFilter configured = settings->scalingFilter();
+    if(viewerWidget->scalingFilter() != FILTER_NEAREST)
         setFilterNearest();
-    else
+    else if(configured == FILTER_NEAREST)
         setFilterBilinear();
+    else
+        setScalingFilter(configured);
 }
 
 void MW::setFilterNearest() {
@@ -271,6 +275,27 @@ void MW::setFilterBilinear() {
     viewerWidget->setFilterBilinear();
 }
 
+void MW::setScalingFilter(ScalingFilter filter) {
+    switch(filter) {
+        case FILTER_NEAREST:
+            setFilterNearest();
+            return;
+        case FILTER_BICUBIC:
+            showMessage("Filter: bicubic", 600);
+            break;
+        case FILTER_CATMULLROM:
+            showMessage("Filter: catmull-rom", 600);
+            break;
+        case FILTER_LANCZOS:
+            showMessage("Filter: lanczos", 600);
+            break;
+        default:
+            showMessage("Filter: bilinear", 600);
+            break;
+    }
+    viewerWidget->setScalingFilter(filter);
+}
+
 bool MW::isCropPanelActive() {
     return (activeSidePanel == SIDEPANEL_CROP);
 }
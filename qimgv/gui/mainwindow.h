@@ -53,7 +53,7 @@ public:
     explicit MW(QWidget *parent = nullptr);
     bool isCropPanelActive();
     void onScalingFinished(std::unique_ptr<QPixmap>scaled);
-    void setImage(std::unique_ptr<QPixmap> pixmap);
+    void setImage(std::unique_ptr<QPixmap> pixmap, QSize sourceSize = QSize());
     void setAnimation(std::unique_ptr<QMovie> movie);
     void setVideo(QString file);
 
@@ -217,5 +217,6 @@ public slots:
     void toggleRenameOverlay();
     void setFilterNearest();
     void setFilterBilinear();
+    void setScalingFilter(ScalingFilter filter);
     void toggleScalingFilter();
 };
@@ -45,51 +45,31 @@ void ThumbnailStrip::ensureSelectedItemVisible() {
 
 }
 
-void ThumbnailStrip::addItemToLayout(ThumbnailWidget* widget, int pos) {
-    scene.addItem(widget);
-    updateThumbnailPositions(pos, thumbnails.count() - 1);
+// single row
+QRectF ThumbnailStrip::itemRect(int index) {
+    qreal step = mItemSize.width() + thumbnailSpacing;
+    return QRectF(index * step, 0, mItemSize.width(), mItemSize.height());
 }
 
-void ThumbnailStrip::removeItemFromLayout(int pos) {
-    if(checkRange(pos)) {
-        ThumbnailWidget *thumb = thumbnails.at(pos);
-        scene.removeItem(thumb);
-        // move items left
-        ThumbnailWidget *tmp;
-        for(int i = pos; i < thumbnails.count(); i++) {
-            tmp = thumbnails.at(i);
-            tmp->moveBy(-tmp->boundingRect().width(), 0);
-        }
+void ThumbnailStrip::itemRange(const QRectF &rect, int &first, int &last) {
+    qreal step = mItemSize.width() + thumbnailSpacing;
+    if(!itemCount() || step <= 0) {
+        first = 0;
+        last = -1;
+        return;
     }
+    first = qMax(0, static_cast<int>(floor(rect.left() / step)));
+    last = qMin(itemCount() - 1, static_cast<int>(floor(rect.right() / step)));
 }
 
-void ThumbnailStrip::removeAll() {
-    scene.clear(); // also calls delete on all items
-    thumbnails.clear();
-}
-
-void ThumbnailStrip::updateThumbnailPositions() {
-    updateThumbnailPositions(0, thumbnails.count() - 1);
-}
-
-void ThumbnailStrip::updateThumbnailPositions(int start, int end) {
-    if(start > end || !checkRange(start) || !checkRange(end)) {
-        return;
-    }
-    // assume all thumbnails are the same size
-    int thumbWidth = static_cast<int>(thumbnails.at(start)->boundingRect().width()) + thumbnailSpacing;
-    ThumbnailWidget *tmp;
-    for(int i = start; i <= end; i++) {
-        tmp = thumbnails.at(i);
-        tmp->setPos(i * thumbWidth, 0);
-    }
+void ThumbnailStrip::updateLayout() {
+    updateItemSize();
 }
 
 void ThumbnailStrip::focusOn(int index) {
     if(!checkRange(index))
         return;
-    ThumbnailWidget *thumb = thumbnails.at(index);
-    ensureVisible(thumb, 0, 0);
+    ensureVisible(itemRect(index), 0, 0);
     loadVisibleThumbnails();
 }
 
@@ -99,20 +79,19 @@ void ThumbnailStrip::readSettings() {
 
 void ThumbnailStrip::ensureThumbnailVisible(int pos) {
     if(checkRange(pos))
-        ensureVisible(thumbnails.at(pos)->sceneBoundingRect(),
-                      mThumbnailSize / 2, 0);
+        ensureVisible(itemRect(pos), mThumbnailSize / 2, 0);
 }
 
 // scene stuff??
 void ThumbnailStrip::setThumbnailSize(int newSize) {
     if(newSize >= 20) {
         mThumbnailSize = newSize;
-        for(int i=0; i<thumbnails.count(); i++) {
-            thumbnails.at(i)->setThumbnailSize(newSize);
-        }
+        for(auto widget : allWidgets())
+            widget->setThumbnailSize(newSize);
         //scene.invalidate(scene.sceneRect());
-        updateThumbnailPositions(0, thumbnails.count() - 1);
+        updateLayout();
         fitSceneToContents();
+        updateVisibleItems();
         ensureThumbnailVisible(selectedIndex());
     }
 }
@@ -124,8 +103,10 @@ void ThumbnailStrip::resizeEvent(QResizeEvent *event) {
     ThumbnailView::resizeEvent(event);
     if(event->oldSize().height() != height())
         updateThumbnailSize();
-    if(event->oldSize().width() < width())
+    if(event->oldSize().width() < width()) {
+        updateVisibleItems();
         loadVisibleThumbnailsDelayed();
+    }
 }
 
 // update size based on widget's size
@@ -28,8 +28,6 @@ private:
 
     int thumbnailSpacing;
 
-    void updateThumbnailPositions(int start, int end);
-    void updateThumbnailPositions();
     void setThumbnailSize(int);
     void updateThumbnailSize();
     void setupLayout();
@@ -44,9 +42,9 @@ protected:
     virtual void resizeEvent(QResizeEvent *event);
     virtual void updateScrollbarIndicator();
     void ensureThumbnailVisible(int pos);
-    void addItemToLayout(ThumbnailWidget *widget, int pos);
-    void removeItemFromLayout(int pos);
-    void removeAll();
+    QRectF itemRect(int index);
+    void itemRange(const QRectF &rect, int &first, int &last);
+    void updateLayout();
     ThumbnailWidget *createThumbnailWidget();
     void ensureSelectedItemVisible();
 };
@@ -85,10 +85,18 @@ void ImageViewer::displayAnimation(std::unique_ptr<QMovie> _movie) {
 
 // display & initialize
 void ImageViewer::displayImage(std::unique_ptr<QPixmap> _pixmap) {
+    displayImage(std::move(_pixmap), QSize());
+}
+
+// geometry is calculated for sourceSize; the pixmap gets stretched
+// over it until a properly scaled one arrives via replacePixmap()
+void ImageViewer::displayImage(std::unique_ptr<QPixmap> _pixmap, QSize sourceSize) {
     reset();
     if(_pixmap) {
         pixmap = std::move(_pixmap);
-        readjust(pixmap->size(), pixmap->rect());
+        if(!sourceSize.isValid())
+            sourceSize = pixmap->size();
+        readjust(sourceSize, QRect(QPoint(0, 0), sourceSize));
         if(transparencyGridEnabled)
             drawTransparencyGrid();
         update();
@@ -179,10 +187,8 @@ void ImageViewer::toggleTransparencyGrid() {
 
 void ImageViewer::setScalingFilter(ScalingFilter filter) {
     if(mScalingFilter != filter) {
-        if(filter == FILTER_NEAREST)
-            setFilterNearest();
-        else if(filter == FILTER_BILINEAR)
-            setFilterBilinear();
+        mScalingFilter = filter;
+        requestScaling(true);
     }
 }
 
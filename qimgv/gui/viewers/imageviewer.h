@@ -38,6 +38,8 @@ public:
     float currentScale();
     QSize sourceSize();
     void displayImage(std::unique_ptr<QPixmap> _pixmap);
+    // pixmap may be a reduced copy of a larger image
+    void displayImage(std::unique_ptr<QPixmap> _pixmap, QSize sourceSize);
     void displayAnimation(std::unique_ptr<QMovie> _animation);
     void replacePixmap(std::unique_ptr<QPixmap> newFrame);
     bool isDisplaying();
@@ -32,6 +32,7 @@ ViewerWidget::ViewerWidget(QWidget *parent)
     connect(this, &ViewerWidget::toggleTransparencyGrid, imageViewer.get(), &ImageViewer::toggleTransparencyGrid);
     connect(this, &ViewerWidget::setFilterNearest,       imageViewer.get(), &ImageViewer::setFilterNearest);
     connect(this, &ViewerWidget::setFilterBilinear,      imageViewer.get(), &ImageViewer::setFilterBilinear);
+    connect(this, &ViewerWidget::setScalingFilter,       imageViewer.get(), &ImageViewer::setScalingFilter);
 
     videoPlayer.reset(new VideoPlayerInitProxy(this));
     videoPlayer->hide();
@@ -167,12 +168,12 @@ std::shared_ptr<DirectoryViewWrapper> ViewerWidget::getPanel() {
     return mainPanel->getWrapper();
 }
 
-bool ViewerWidget::showImage(std::unique_ptr<QPixmap> pixmap) {
+bool ViewerWidget::showImage(std::unique_ptr<QPixmap> pixmap, QSize sourceSize) {
     if(!pixmap)
         return false;
     stopPlayback();
     enableImageViewer();
-    imageViewer->displayImage(std::move(pixmap));
+    imageViewer->displayImage(std::move(pixmap), sourceSize);
     hideCursorTimed(false);
     return true;
 }
@@ -29,7 +29,7 @@ public:
 
     std::shared_ptr<DirectoryViewWrapper> getPanel();
 
-    bool showImage(std::unique_ptr<QPixmap> pixmap);
+    bool showImage(std::unique_ptr<QPixmap> pixmap, QSize sourceSize = QSize());
     bool showAnimation(std::unique_ptr<QMovie> movie);
     void onScalingFinished(std::unique_ptr<QPixmap> scaled);
     bool isDisplaying();
@@ -76,6 +76,7 @@ signals:
     void draggedOut();
     void setFilterNearest();
     void setFilterBilinear();
+    void setScalingFilter(ScalingFilter filter);
 
 public slots:
     bool showVideo(QString file);
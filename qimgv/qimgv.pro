@@ -79,13 +79,16 @@ SOURCES += \
     components/actionmanager/actionmanager.cpp \
     components/cache/cache.cpp \
     components/cache/thumbnailcache.cpp \
+    components/cache/scaledcache.cpp \
     components/directorymanager/directorymanager.cpp \
+    components/directorymanager/entryindex.cpp \
     components/directorymanager/watchers/directorywatcher.cpp \
     components/loader/loader.cpp \
     components/loader/loaderrunnable.cpp \
     components/scaler/scaler.cpp \
     components/scaler/scalerrunnable.cpp \
     components/thumbnailer/thumbnailer.cpp \
+    components/thumbnailer/framegrabberpool.cpp \
     gui/mainwindow.cpp \
     gui/dialogs/settingsdialog.cpp \
     gui/dialogs/resizedialog.cpp \
@@ -112,6 +115,8 @@ SOURCES += \
     sourcecontainers/video.cpp \
     utils/imagefactory.cpp \
     utils/imagelib.cpp \
+    utils/resampler.cpp \
+    utils/cancellablefile.cpp \
     utils/sleep.cpp \
     utils/stuff.cpp \
     utils/wallpapersetter.cpp \
@@ -147,7 +152,6 @@ SOURCES += \
     sourcecontainers/documentinfo.cpp \
     gui/overlays/videocontrols.cpp \
     gui/customwidgets/videoslider.cpp \
-    gui/flowlayout.cpp \
     gui/customwidgets/thumbnailview.cpp \
     gui/customwidgets/thumbnailwidget.cpp \
     gui/folderview/folderview.cpp \
@@ -171,7 +175,11 @@ HEADERS += \
     components/actionmanager/actionmanager.h \
     components/cache/cache.h \
     components/cache/thumbnailcache.h \
+    components/cache/scaledcache.h \
     components/directorymanager/directorymanager.h \
+    components/directorymanager/directorychanges.h \
+    components/directorymanager/entry.h \
+    components/directorymanager/entryindex.h \
     components/directorymanager/watchers/directorywatcher_p.h \
     components/directorymanager/watchers/directorywatcher.h \
     components/directorymanager/watchers/watcherevent.h \
@@ -181,6 +189,8 @@ HEADERS += \
     components/scaler/scalerrequest.h \
     components/scaler/scalerrunnable.h \
     components/thumbnailer/thumbnailer.h \
+    components/thumbnailer/framegrabber.h \
+    components/thumbnailer/framegrabberpool.h \
     gui/mainwindow.h \
     gui/dialogs/settingsdialog.h \
     gui/dialogs/resizedialog.h \
@@ -209,6 +219,8 @@ HEADERS += \
     sourcecontainers/video.h \
     utils/imagefactory.h \
     utils/imagelib.h \
+    utils/resampler.h \
+    utils/cancellablefile.h \
     utils/stuff.h \
     utils/wallpapersetter.h \
     settings.h \
@@ -243,7 +255,6 @@ HEADERS += \
     sourcecontainers/documentinfo.h \
     gui/overlays/videocontrols.h \
     gui/customwidgets/videoslider.h \
-    gui/flowlayout.h \
     gui/customwidgets/thumbnailview.h \
     gui/customwidgets/thumbnailwidget.h \
     gui/folderview/folderview.h \
@@ -289,13 +300,26 @@ unix {
     SOURCES += \
         components/directorymanager/watchers/linux/linuxworker.cpp \
         components/directorymanager/watchers/linux/linuxwatcher.cpp \
-        components/directorymanager/watchers/linux/linuxfsevent.cpp
+        components/directorymanager/watchers/linux/linuxeventbuffer.cpp
 
     HEADERS += \
-        components/directorymanager/watchers/linux/linuxfsevent.h \
+        components/directorymanager/watchers/linux/linuxeventbuffer.h \
         components/directorymanager/watchers/linux/linuxwatcher.h \
         components/directorymanager/watchers/linux/linuxworker.h \
         components/directorymanager/watchers/linux/linuxwatcher_p.h
+
+    SOURCES += \
+        components/directorymanager/watchers/pollingwatcher.cpp \
+        components/directorymanager/watchers/pollingworker.cpp
+
+    HEADERS += \
+        components/directorymanager/watchers/pollingwatcher.h \
+        components/directorymanager/watchers/pollingworker.h
+
+    linux {
+        SOURCES += components/directorymanager/directoryscanner.cpp
+        HEADERS += components/directorymanager/directoryscanner.h
+    }
 }
 
 windows {
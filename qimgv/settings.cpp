@@ -302,6 +302,45 @@ void Settings::setUsePreloader(bool mode) {
     settings->s->setValue("usePreloader", mode);
 }
 //------------------------------------------------------------------------------
+// in megabytes
+int Settings::imageCacheSize() {
+    int size = settings->s->value("imageCacheSize", 768).toInt();
+    if(size < 64)
+        size = 64;
+    return size;
+}
+
+void Settings::setImageCacheSize(int megabytes) {
+    settings->s->setValue("imageCacheSize", megabytes);
+}
+//------------------------------------------------------------------------------
+// images preloaded in the navigation direction
+int Settings::preloadAhead() {
+    return std::clamp(settings->s->value("preloadAhead", 2).toInt(), 0, 16);
+}
+
+void Settings::setPreloadAhead(int count) {
+    settings->s->setValue("preloadAhead", count);
+}
+//------------------------------------------------------------------------------
+// images preloaded in the opposite direction
+int Settings::preloadBehind() {
+    return std::clamp(settings->s->value("preloadBehind", 1).toInt(), 0, 16);
+}
+
+void Settings::setPreloadBehind(int count) {
+    settings->s->setValue("preloadBehind", count);
+}
+//------------------------------------------------------------------------------
+// decode large stills at screen resolution, full one is loaded when zooming in
+bool Settings::screenSizeDecoding() {
+    return settings->s->value("screenSizeDecoding", false).toBool();
+}
+
+void Settings::setScreenSizeDecoding(bool mode) {
+    settings->s->setValue("screenSizeDecoding", mode);
+}
+//------------------------------------------------------------------------------
 QColor Settings::backgroundColor() {
     return settings->s->value("bgColor", QColor(27, 27, 28)).value<QColor>();
 }
@@ -559,6 +598,18 @@ void Settings::setUseThumbnailCache(bool mode) {
     settings->s->setValue("thumbnailCache", mode);
 }
 //------------------------------------------------------------------------------
+// on-disk thumbnail store limit, in megabytes
+int Settings::thumbnailCacheSize() {
+    int size = settings->s->value("thumbnailCacheSize", 1024).toInt();
+    if(size < 64)
+        size = 64;
+    return size;
+}
+
+void Settings::setThumbnailCacheSize(int megabytes) {
+    settings->s->setValue("thumbnailCacheSize", megabytes);
+}
+//------------------------------------------------------------------------------
 QStringList Settings::savedPaths() {
     return settings->state->value("savedPaths").toStringList();
 }
@@ -629,7 +680,7 @@ void Settings::setJPEGSaveQuality(int value) {
 //------------------------------------------------------------------------------
 ScalingFilter Settings::scalingFilter() {
     int mode = settings->s->value("scalingFilter", 1).toInt();
-    if(mode < 0 || mode > 1)
+    if(mode < 0 || mode > 4)
         mode = 1;
     return static_cast<ScalingFilter>(mode);
 }
@@ -713,3 +764,12 @@ void Settings::setZoomStep(qreal value) {
         value = 0.1;
     settings->s->setValue("zoomStep", value);
 }
+//------------------------------------------------------------------------------
+// poll directories even where the native watcher works
+bool Settings::forcePollingWatcher() {
+    return settings->s->value("forcePollingWatcher", false).toBool();
+}
+
+void Settings::setForcePollingWatcher(bool mode) {
+    settings->s->setValue("forcePollingWatcher", mode);
+}
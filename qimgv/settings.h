@@ -42,7 +42,10 @@ enum PanelVPosition {
 
 enum ScalingFilter {
     FILTER_NEAREST,
-    FILTER_BILINEAR
+    FILTER_BILINEAR,
+    FILTER_BICUBIC,
+    FILTER_CATMULLROM,
+    FILTER_LANCZOS
 };
 
 class Settings : public QObject
@@ -64,6 +67,14 @@ public:
     void setMainPanelSize(unsigned int size);
     bool usePreloader();
     void setUsePreloader(bool mode);
+    int imageCacheSize();
+    void setImageCacheSize(int megabytes);
+    int preloadAhead();
+    void setPreloadAhead(int count);
+    int preloadBehind();
+    void setPreloadBehind(int count);
+    bool screenSizeDecoding();
+    void setScreenSizeDecoding(bool mode);
     QColor backgroundColor();
     void setBackgroundColor(QColor color);
     QColor accentColor();
@@ -114,6 +125,8 @@ public:
     void setEnableSmoothScroll(bool mode);
     bool useThumbnailCache();
     void setUseThumbnailCache(bool mode);
+    int thumbnailCacheSize();
+    void setThumbnailCacheSize(int megabytes);
     QStringList savedPaths();
     void setSavedPaths(QStringList paths);
     QString cacheDir();
@@ -187,6 +200,9 @@ public:
     void setZoomStep(qreal value);
     int JPEGSaveQuality();
     void setJPEGSaveQuality(int value);
+
+    bool forcePollingWatcher();
+    void setForcePollingWatcher(bool mode);
 private:
     explicit Settings(QObject *parent = nullptr);
     const unsigned int mainPanelSizeDefault = 230;
@@ -118,6 +118,70 @@ void DocumentInfo::detectFormat() {
     //qDebug() << mFormat << mDocumentType << mimeName;
 }
 
+namespace {
+
+// IFD1 thumbnail (JPEGInterchangeFormat) of a tiff structure
+QByteArray tiffThumbnail(const QByteArray &tiff) {
+    const uchar *d = reinterpret_cast<const uchar*>(tiff.constData());
+    const qint64 n = tiff.size();
+    if(n < 8)
+        return QByteArray();
+    bool le = (d[0] == 'I' && d[1] == 'I');
+    if(!le && !(d[0] == 'M' && d[1] == 'M'))
+        return QByteArray();
+    auto u16 = [&](qint64 o) -> qint64 {
+        if(o < 0 || o + 2 > n)
+            return 0;
+        return le ? (d[o] | d[o + 1] << 8) : (d[o] << 8 | d[o + 1]);
+    };
+    auto u32 = [&](qint64 o) -> qint64 {
+        if(o < 0 || o + 4 > n)
+            return 0;
+        return le ? (u16(o) | u16(o + 2) << 16) : (u16(o) << 16 | u16(o + 2));
+    };
+    qint64 ifd0 = u32(4);
+    qint64 ifd1 = u32(ifd0 + 2 + u16(ifd0) * 12);
+    if(ifd1 <= 0)
+        return QByteArray();
+    qint64 offset = 0, length = 0;
+    for(qint64 i = 0; i < u16(ifd1); i++) {
+        qint64 entry = ifd1 + 2 + i * 12;
+        if(u16(entry) == 0x0201)
+            offset = u32(entry + 8);
+        else if(u16(entry) == 0x0202)
+            length = u32(entry + 8);
+    }
+    if(offset <= 0 || length <= 0 || offset + length > n)
+        return QByteArray();
+    return tiff.mid(static_cast<int>(offset), static_cast<int>(length));
+}
+
+}
+
+// walks jpeg markers up to the exif block, no decoding involved
+QByteArray DocumentInfo::exifThumbnail() const {
+    QFile f(fileInfo.filePath());
+    if(!f.open(QIODevice::ReadOnly) || f.read(2) != QByteArray("\xFF\xD8", 2))
+        return QByteArray();
+    while(true) {
+        QByteArray marker = f.read(4);
+        if(marker.size() < 4 || static_cast<uchar>(marker.at(0)) != 0xFF)
+            return QByteArray();
+        uchar type = static_cast<uchar>(marker.at(1));
+        int length = (static_cast<uchar>(marker.at(2)) << 8) | static_cast<uchar>(marker.at(3));
+        // start of scan: no more metadata after this
+        if(type == 0xDA || type == 0xD9 || length < 2)
+            return QByteArray();
+        if(type == 0xE1) {
+            QByteArray segment = f.read(length - 2);
+            if(segment.startsWith(QByteArray("Exif\0\0", 6)))
+                return tiffThumbnail(segment.mid(6));
+        } else if(!f.seek(f.pos() + length - 2)) {
+            return QByteArray();
+        }
+    }
+}
+
 inline
 // dumb apng detector
 bool DocumentInfo::detectAPNG() {
@@ -237,6 +301,79 @@ QMap<QString, QString> DocumentInfo::getExifTags() {
     return exifTags;
 }
 
+// Most camera files carry a small exif thumbnail or a bigger preview jpeg.
+// Decoding those is a lot cheaper than the full image.
+QByteArray DocumentInfo::embeddedPreview(QSize minSize) const {
+    if(mDocumentType != STATIC)
+        return QByteArray();
+#ifdef USE_EXIV2
+    try {
+        std::unique_ptr<Exiv2::Image> image;
+
+        image = Exiv2::ImageFactory::open(toStdString(fileInfo.filePath()));
+
+        assert(image.get() != 0);
+        image->readMetadata();
+        Exiv2::PreviewManager manager(*image);
+        // sorted by size, smallest first
+        Exiv2::PreviewPropertiesList list = manager.getPreviewProperties();
+        for(auto &properties : list) {
+            if(static_cast<int>(properties.width_) >= minSize.width() &&
+               static_cast<int>(properties.height_) >= minSize.height()) {
+                Exiv2::PreviewImage preview = manager.getPreviewImage(properties);
+                return QByteArray(reinterpret_cast<const char*>(preview.pData()), static_cast<int>(preview.size()));
+            }
+        }
+        return QByteArray();
+    }
+    catch (Exiv2::Error& e) {
+        std::cout << "Caught Exiv2 exception '" << e.what() << "'\n";
+        return QByteArray();
+    }
+#else
+    if(mFormat != "jpg")
+        return QByteArray();
+    QByteArray data = exifThumbnail();
+    if(data.isEmpty())
+        return data;
+    QBuffer buffer(&data);
+    QImageReader reader(&buffer, "jpg");
+    QSize size = reader.size();
+    if(size.width() < minSize.width() || size.height() < minSize.height())
+        return QByteArray();
+    return data;
+#endif
+}
+
+QSize DocumentInfo::metadataImageSize() const {
+#ifdef USE_EXIV2
+    try {
+        std::unique_ptr<Exiv2::Image> image;
+
+        image = Exiv2::ImageFactory::open(toStdString(fileInfo.filePath()));
+
+        assert(image.get() != 0);
+        image->readMetadata();
+        QSize size(image->pixelWidth(), image->pixelHeight());
+        if(size.isValid() && !size.isEmpty())
+            return size;
+        Exiv2::ExifData &exifData = image->exifData();
+        Exiv2::ExifData::const_iterator width = exifData.findKey(Exiv2::ExifKey("Exif.Photo.PixelXDimension"));
+        Exiv2::ExifData::const_iterator height = exifData.findKey(Exiv2::ExifKey("Exif.Photo.PixelYDimension"));
+        if(width != exifData.end() && height != exifData.end()) {
+            size = QSize(QString::fromStdString(width->value().toString()).toInt(),
+                         QString::fromStdString(height->value().toString()).toInt());
+            if(size.isValid() && !size.isEmpty())
+                return size;
+        }
+    }
+    catch (Exiv2::Error& e) {
+        std::cout << "Caught Exiv2 exception '" << e.what() << "'\n";
+    }
+#endif
+    return QSize();
+}
+
 void DocumentInfo::loadExifOrientation() {
     if(mDocumentType == VIDEO || mDocumentType == NONE)
         return;
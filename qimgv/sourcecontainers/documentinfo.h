@@ -21,6 +21,7 @@
 #endif
 
 #include <QImageReader>
+#include <QBuffer>
 
 enum DocumentType { NONE, STATIC, ANIMATED, VIDEO };
 
@@ -45,6 +46,10 @@ public:
     void refresh();
     void loadExifInfo();
     QMap<QString, QString> getExifTags();
+    // smallest embedded preview at least minSize large, as encoded data
+    QByteArray embeddedPreview(QSize minSize) const;
+    // full image size from metadata, for files qt can't read (raw without a plugin)
+    QSize metadataImageSize() const;
 
 private:
     QFileInfo fileInfo;
@@ -58,6 +63,7 @@ private:
     void loadExifOrientation();
     bool detectAPNG();
     bool detectAnimatedWebP();
+    QByteArray exifThumbnail() const;
     QMap<QString, QString> exifTags;
     QMimeType mMimeType;
 };
@@ -4,6 +4,7 @@ Image::Image(QString _path)
     : mDocInfo(new DocumentInfo(_path)),
       mLoaded(false),
       mEdited(false),
+      mReduced(false),
       mPath(_path)
 {
 }
@@ -12,6 +13,7 @@ Image::Image(std::unique_ptr<DocumentInfo> _info)
     : mDocInfo(std::move(_info)),
       mLoaded(false),
       mEdited(false),
+      mReduced(false),
       mPath(mDocInfo->filePath())
 {
 }
@@ -43,6 +45,10 @@ bool Image::isEdited() const {
     return mEdited;
 }
 
+bool Image::isReduced() const {
+    return mReduced;
+}
+
 qint64 Image::fileSize() const {
     return mDocInfo->fileSize();
 }
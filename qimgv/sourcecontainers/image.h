@@ -26,6 +26,8 @@ public:
     QString name() const;
     QString baseName() const;
     bool isEdited() const;
+    // decoded at lower resolution than the file has; size() still reports the full one
+    bool isReduced() const;
     qint64 fileSize() const;
     QDateTime lastModified() const;
     QMap<QString, QString> getExifTags();
@@ -33,7 +35,7 @@ public:
 protected:
     virtual void load() = 0;
     std::unique_ptr<DocumentInfo> mDocInfo;
-    bool mLoaded, mEdited;
+    bool mLoaded, mEdited, mReduced;
     QString mPath;
     QSize resolution;
 };
@@ -1,4 +1,5 @@
 #include "imagestatic.h"
+#include "utils/cancellablefile.h"
 #include <time.h>
 
 ImageStatic::ImageStatic(QString _path)
@@ -7,10 +8,10 @@ ImageStatic::ImageStatic(QString _path)
     load();
 }
 
-ImageStatic::ImageStatic(std::unique_ptr<DocumentInfo> _info)
+ImageStatic::ImageStatic(std::unique_ptr<DocumentInfo> _info, const std::atomic_bool *cancelled, QSize decodeSize)
     : Image(std::move(_info))
 {
-    load();
+    load(cancelled, decodeSize);
 }
 
 ImageStatic::~ImageStatic() {
@@ -18,19 +19,43 @@ ImageStatic::~ImageStatic() {
 
 //load image data from disk
 void ImageStatic::load() {
+    load(nullptr, QSize());
+}
+
+void ImageStatic::load(const std::atomic_bool *cancelled, QSize decodeSize) {
     if(isLoaded()) {
         return;
     }
     if(mDocInfo->mimeType().name() == "image/vnd.microsoft.icon")
         loadICO();
     else
-        loadGeneric();
-}
-
-
-void ImageStatic::loadGeneric() {
-    std::unique_ptr<const QImage> img(new QImage(mPath, mDocInfo->format().toStdString().c_str()));
-    img = ImageLib::exifRotated(std::move(img), mDocInfo.get()->exifOrientation());
+        loadGeneric(cancelled, decodeSize);
+}
+
+// reads through CancellableFile so the decoder can be stopped midway
+void ImageStatic::loadGeneric(const std::atomic_bool *cancelled, QSize decodeSize) {
+    CancellableFile file(mPath, cancelled);
+    file.open(QIODevice::ReadOnly);
+    QImageReader reader(&file, mDocInfo->format().toStdString().c_str());
+    int orientation = mDocInfo.get()->exifOrientation();
+    QSize fullSize = reader.size();
+    if(decodeSize.isValid() && fullSize.isValid()) {
+        // fit the longest side, so the result is the same for any exif rotation
+        int side = qMax(decodeSize.width(), decodeSize.height());
+        QSize reducedSize = fullSize.scaled(side, side, Qt::KeepAspectRatio);
+        // not worth it unless we skip most of the pixels
+        // jpeg handler uses libjpeg's DCT scaling for this, which is a lot faster
+        if(reducedSize.width() * 2 < fullSize.width()) {
+            reader.setScaledSize(reducedSize);
+            mReduced = true;
+        }
+    }
+    // rotations by 90 degrees
+    if(orientation >= 4 && orientation <= 7)
+        fullSize.transpose();
+    resolution = fullSize;
+    std::unique_ptr<const QImage> img(new QImage(reader.read()));
+    img = ImageLib::exifRotated(std::move(img), orientation);
     // set image
     image = std::move(img);
     mLoaded = true;
@@ -57,6 +82,9 @@ QString ImageStatic::generateHash(QString str) {
 
 // TODO: move saving to directorymodel
 bool ImageStatic::save(QString destPath) {
+    // would overwrite the file with a downscaled copy
+    if(isReduced() && !isEdited())
+        return false;
     QString tmpPath = destPath + "_" + generateHash(destPath);
     QFileInfo fi(destPath);
     QString ext = fi.suffix();
@@ -124,21 +152,60 @@ std::shared_ptr<const QImage> ImageStatic::getImage() {
     return isEdited()?imageEdited:image;
 }
 
+std::shared_ptr<const QImage> ImageStatic::getMipmap(QSize targetSize) {
+    QMutexLocker locker(&mipmapMutex);
+    auto source = getImage();
+    if(!source || source->width() * source->height() < MIPMAP_MIN_PIXELS)
+        return source;
+    if(mipmaps.empty() || mipmaps.front() != source) {
+        mipmaps.clear();
+        mipmaps.push_back(source);
+        mipmapBytes = 0;
+    }
+    size_t level = 0;
+    for(;;) {
+        QSize half = mipmaps[level]->size() / 2;
+        if(half.isEmpty() || half.width() < targetSize.width() || half.height() < targetSize.height())
+            break;
+        // each level is a 2x box filter of the previous one
+        if(level + 1 == mipmaps.size()) {
+            mipmaps.push_back(std::make_shared<const QImage>(
+                        mipmaps[level]->scaled(half, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)));
+            mipmapBytes += static_cast<qint64>(mipmaps.back()->bytesPerLine()) * mipmaps.back()->height();
+        }
+        level++;
+    }
+    return mipmaps[level];
+}
+
+qint64 ImageStatic::mipmapSize() {
+    return mipmapBytes.load();
+}
+
+void ImageStatic::clearMipmaps() {
+    QMutexLocker locker(&mipmapMutex);
+    mipmaps.clear();
+    mipmapBytes = 0;
+}
+
 int ImageStatic::height() {
-    return isEdited()?imageEdited->height():image->height();
+    return size().height();
 }
 
 int ImageStatic::width() {
-    return isEdited()?imageEdited->width():image->width();
+    return size().width();
 }
 
 QSize ImageStatic::size() {
-    return isEdited()?imageEdited->size():image->size();
+    if(isEdited())
+        return imageEdited->size();
+    return isReduced() ? resolution : image->size();
 }
 
 bool ImageStatic::setEditedImage(std::unique_ptr<const QImage> imageEditedNew) {
     if(imageEditedNew && imageEditedNew->width() != 0) {
         discardEditedImage();
+        clearMipmaps();
         imageEdited = std::move(imageEditedNew);
         mEdited = true;
         return true;
@@ -148,6 +215,7 @@ bool ImageStatic::setEditedImage(std::unique_ptr<const QImage> imageEditedNew) {
 
 bool ImageStatic::discardEditedImage() {
     if(imageEdited) {
+        clearMipmaps();
         imageEdited.reset();
         mEdited = false;
         return true;
@@ -1,23 +1,33 @@
 #pragma once
 
 #include <QImage>
+#include <QImageReader>
 #include <QImageWriter>
 #include <QSemaphore>
+#include <QMutex>
 #include <QCryptographicHash>
 #include "image.h"
 #include "utils/imagelib.h"
 #include <settings.h>
 #include <QIcon>
+#include <atomic>
+#include <vector>
 
 class ImageStatic : public Image {
 public:
     ImageStatic(QString _path);
-    ImageStatic(std::unique_ptr<DocumentInfo> _info);
+    // non-empty decodeSize allows decoding large images at reduced resolution
+    ImageStatic(std::unique_ptr<DocumentInfo> _info, const std::atomic_bool *cancelled = nullptr, QSize decodeSize = QSize());
     ~ImageStatic();
 
     std::unique_ptr<QPixmap> getPixmap();
     std::shared_ptr<const QImage> getSourceImage();
     std::shared_ptr<const QImage> getImage();
+    // smallest of 1/2, 1/4 ... copies which is still larger than targetSize
+    // levels are built on first use, so call this from a worker thread
+    std::shared_ptr<const QImage> getMipmap(QSize targetSize);
+    // bytes held by the levels built so far, not counting the image
+    qint64 mipmapSize();
 
     int height();
     int width();
@@ -33,8 +43,18 @@ public slots:
 
 private:
     void load();
+    void load(const std::atomic_bool *cancelled, QSize decodeSize);
     std::shared_ptr<const QImage> image, imageEdited;
-    void loadGeneric();
+    void loadGeneric(const std::atomic_bool *cancelled, QSize decodeSize);
     void loadICO();
     QString generateHash(QString str);
+
+    // level 0 is the image itself
+    std::vector<std::shared_ptr<const QImage>> mipmaps;
+    QMutex mipmapMutex;
+    // readable without waiting for a level being built
+    std::atomic<qint64> mipmapBytes{0};
+    void clearMipmaps();
+    // not worth it for anything smaller
+    const int MIPMAP_MIN_PIXELS = 4096 * 3072;
 };
@@ -0,0 +1,13 @@
+#include "cancellablefile.h"
+
+CancellableFile::CancellableFile(const QString &path, const std::atomic_bool *_cancelled)
+    : QFile(path),
+      cancelled(_cancelled)
+{
+}
+
+qint64 CancellableFile::readData(char *data, qint64 maxSize) {
+    if(cancelled && *cancelled)
+        return -1;
+    return QFile::readData(data, maxSize);
+}
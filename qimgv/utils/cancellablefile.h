@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QFile>
+#include <atomic>
+
+// QFile which fails all reads once the flag is set.
+// Image decoders read in small chunks, so they bail out
+// shortly after cancellation instead of finishing the whole file.
+class CancellableFile : public QFile {
+public:
+    CancellableFile(const QString &path, const std::atomic_bool *_cancelled);
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+private:
+    const std::atomic_bool *cancelled;
+};
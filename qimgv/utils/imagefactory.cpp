@@ -1,6 +1,6 @@
 #include "imagefactory.h"
 
-std::shared_ptr<Image> ImageFactory::createImage(QString path) {
+std::shared_ptr<Image> ImageFactory::createImage(QString path, const std::atomic_bool *cancelled, QSize decodeSize) {
     std::unique_ptr<DocumentInfo> docInfo(new DocumentInfo(path));
     std::shared_ptr<Image> img;
     if(docInfo->type() == NONE) {
@@ -10,7 +10,10 @@ std::shared_ptr<Image> ImageFactory::createImage(QString path) {
     } else if(docInfo->type() == VIDEO) {
         img.reset(new Video(move(docInfo)));
     } else {
-        img.reset(new ImageStatic(move(docInfo)));
+        img.reset(new ImageStatic(move(docInfo), cancelled, decodeSize));
     }
+    // decoding was aborted midway; don't hand out a broken image
+    if(cancelled && *cancelled)
+        img.reset();
     return img;
 }
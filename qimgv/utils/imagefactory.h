@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include "utils/imagelib.h"
 #include "sourcecontainers/documentinfo.h"
 #include "sourcecontainers/image.h"
@@ -9,5 +10,7 @@
 
 class ImageFactory {
 public:
-    static std::shared_ptr<Image> createImage(QString path);
+    // returns nullptr if unsupported or cancelled
+    // decodeSize: see ImageStatic
+    static std::shared_ptr<Image> createImage(QString path, const std::atomic_bool *cancelled = nullptr, QSize decodeSize = QSize());
 };
@@ -127,21 +127,25 @@ QImage *ImageLib::cropped(QRect newRect, QRect targetRes, bool upscaled) {
 
 /* 0: nearest
  * 1: bilinear
+ * 2: bicubic
+ * 3: catmull-rom
+ * 4: lanczos3
+ * returns nullptr if cancelled
  */
 
-QImage* ImageLib::scaled(std::shared_ptr<const QImage> source, QSize destSize, int method) {
+QImage* ImageLib::scaled(std::shared_ptr<const QImage> source, QSize destSize, int method,
+                         const std::atomic_bool *cancelled) {
     switch (method) {
         case 0:
             return scaled_Qt(source, destSize, false);
         case 1:
-            return scaled_Qt(source, destSize, true);
-        /*case 2:
-            return scale_FreeImage(source, destSize, FILTER_BICUBIC);
+            return scaled_Resampler(source, destSize, KERNEL_BILINEAR, cancelled);
+        case 2:
+            return scaled_Resampler(source, destSize, KERNEL_BICUBIC, cancelled);
         case 3:
-            return scale_FreeImage(source, destSize, FILTER_CATMULLROM);
+            return scaled_Resampler(source, destSize, KERNEL_CATMULLROM, cancelled);
         case 4:
-            return scale_FreeImage(source, destSize, FILTER_LANCZOS3);
-            */
+            return scaled_Resampler(source, destSize, KERNEL_LANCZOS3, cancelled);
         default:
             return scaled_Qt(source, destSize, true);
     }
@@ -154,24 +158,13 @@ QImage* ImageLib::scaled_Qt(std::shared_ptr<const QImage> source, QSize destSize
     return dest;
 }
 
-/*
-QImage* ImageLib::scale_FreeImage(const QImage *source, QSize destSize, FREE_IMAGE_FILTER filter) {
-    FIBITMAP *fiOrig = FreeImage_ConvertFromRawBitsEx(false, (BYTE*)source->bits(),
-                                                      FIT_BITMAP,
-                                                      source->width(),
-                                                      source->height(),
-                                                      source->bytesPerLine(),
-                                                      source->depth(),
-                                                      FI_RGBA_RED_MASK,
-                                                      FI_RGBA_GREEN_MASK,
-                                                      FI_RGBA_BLUE_MASK);
-    QImage *dest = new QImage(destSize, source->format());
-    FIBITMAP *fiScaled = FreeImage_Rescale(fiOrig, dest->width(), dest->height(), filter);
-    FreeImage_Unload(fiOrig);
-    int pitch = FreeImage_GetPitch(fiScaled);
-    int height = FreeImage_GetHeight(fiScaled);
-    memcpy( dest->bits(), FreeImage_GetBits(fiScaled), pitch * height );
-    FreeImage_Unload(fiScaled);
-    return dest;
+QImage* ImageLib::scaled_Resampler(std::shared_ptr<const QImage> source, QSize destSize, ResampleKernel kernel,
+                                   const std::atomic_bool *cancelled) {
+    // resampler works with 8 bits per channel; leave deeper formats to qt
+    if(source->depth() > 32)
+        return scaled_Qt(source, destSize, true);
+    QImage result = Resampler::resample(*source, destSize, kernel, cancelled);
+    if(cancelled && *cancelled)
+        return nullptr;
+    return new QImage(result);
 }
-*/
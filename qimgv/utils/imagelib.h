@@ -4,7 +4,7 @@
 #include <QPixmapCache>
 #include <QDebug>
 #include <memory>
-//#include <FreeImagePlus.h>
+#include "utils/resampler.h"
 
 class ImageLib {
     public:
@@ -21,11 +21,13 @@ class ImageLib {
         static QImage *flippedV(std::shared_ptr<const QImage> src);
 
         static QImage *scaled(const QImage *source, QSize destSize, int method);
-        static QImage *scaled(std::shared_ptr<const QImage> source, QSize destSize, int method);
+        static QImage *scaled(std::shared_ptr<const QImage> source, QSize destSize, int method,
+                              const std::atomic_bool *cancelled = nullptr);
 
         static QImage *scaled_Qt(const QImage *source, QSize destSize, bool smooth);
         static QImage *scaled_Qt(std::shared_ptr<const QImage> source, QSize destSize, bool smooth);
-        //static QImage *scale_FreeImage(const QImage *source, QSize destSize, FREE_IMAGE_FILTER filter);
+        static QImage *scaled_Resampler(std::shared_ptr<const QImage> source, QSize destSize, ResampleKernel kernel,
+                                        const std::atomic_bool *cancelled = nullptr);
 
         static std::unique_ptr<const QImage> exifRotated(std::unique_ptr<const QImage> src, int orientation);
         static std::unique_ptr<QImage> exifRotated(std::unique_ptr<QImage> src, int orientation);
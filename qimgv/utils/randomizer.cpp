@@ -1,10 +1,10 @@
 #include "randomizer.h"
 
-Randomizer::Randomizer() {
+Randomizer::Randomizer() : currentIndex(0), mForward(true) {
     setCount(0);
 }
 
-Randomizer::Randomizer(int _count) : currentIndex(0) {
+Randomizer::Randomizer(int _count) : currentIndex(0), mForward(true) {
     setCount(_count);
 }
 
@@ -65,6 +65,7 @@ int Randomizer::next() {
         setCurrent(currentItem);
     }
     currentIndex++;
+    mForward = true;
     return vec[currentIndex];
 }
 
@@ -75,5 +76,25 @@ int Randomizer::prev() {
         setCurrent(currentItem);
     }
     currentIndex--;
+    mForward = false;
     return vec[currentIndex];
 }
+
+// these stop at the list boundary, as everything past it gets reshuffled
+std::vector<int> Randomizer::peekNext(int count) const {
+    std::vector<int> items;
+    for(int i = currentIndex + 1; i < int(vec.size()) && int(items.size()) < count; i++)
+        items.push_back(vec[i]);
+    return items;
+}
+
+std::vector<int> Randomizer::peekPrev(int count) const {
+    std::vector<int> items;
+    for(int i = currentIndex - 1; i >= 0 && i < int(vec.size()) && int(items.size()) < count; i--)
+        items.push_back(vec[i]);
+    return items;
+}
+
+bool Randomizer::forward() const {
+    return mForward;
+}
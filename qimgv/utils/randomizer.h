@@ -17,12 +17,18 @@ public:
     void setCount(int _count);
     int next();
     int prev();
+    // upcoming items in the current order, without moving
+    std::vector<int> peekNext(int count) const;
+    std::vector<int> peekPrev(int count) const;
+    // direction of the last next() / prev() call
+    bool forward() const;
 
     void shuffle();
     void print();
     void setCurrent(int _current);
 private:
     int currentIndex;
+    bool mForward;
     std::vector<int> vec;
     void fill();
     int indexOf(int n);
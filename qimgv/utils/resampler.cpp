@@ -0,0 +1,443 @@
+#include "resampler.h"
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define RESAMPLER_SSE2
+    #include <emmintrin.h>
+    #if defined(__GNUC__)
+        // avx2 path is compiled per-function and selected at runtime
+        #define RESAMPLER_AVX2
+        #include <immintrin.h>
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define RESAMPLER_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+// weights are 1.14 fixed point so they fit into int16 for madd-style instructions
+const int PRECISION_BITS = 14;
+const int ROUNDING = 1 << (PRECISION_BITS - 1);
+// smaller outputs are not worth waking up the worker threads
+const qint64 PARALLEL_MIN_PIXELS = 512 * 512;
+// minimum amount of source rows handled by one band
+const int BAND_SOURCE_ROWS = 32;
+
+struct Kernel {
+    double support;
+    double (*weight)(double);
+};
+
+double cubic(double x, double b, double c) {
+    x = std::abs(x);
+    if(x < 1.0)
+        return ((12.0 - 9.0 * b - 6.0 * c) * x * x * x + (-18.0 + 12.0 * b + 6.0 * c) * x * x + (6.0 - 2.0 * b)) / 6.0;
+    if(x < 2.0)
+        return ((-b - 6.0 * c) * x * x * x + (6.0 * b + 30.0 * c) * x * x + (-12.0 * b - 48.0 * c) * x + (8.0 * b + 24.0 * c)) / 6.0;
+    return 0.0;
+}
+
+double sinc(double x) {
+    if(x == 0.0)
+        return 1.0;
+    x *= PI;
+    return std::sin(x) / x;
+}
+
+double bilinearWeight(double x) {
+    x = std::abs(x);
+    return (x < 1.0) ? 1.0 - x : 0.0;
+}
+
+// mitchell-netravali
+double bicubicWeight(double x) {
+    return cubic(x, 1.0 / 3.0, 1.0 / 3.0);
+}
+
+double catmullRomWeight(double x) {
+    return cubic(x, 0.0, 0.5);
+}
+
+double lanczos3Weight(double x) {
+    return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+}
+
+Kernel kernelFor(ResampleKernel kernel) {
+    switch(kernel) {
+        case KERNEL_BICUBIC:
+            return { 2.0, bicubicWeight };
+        case KERNEL_CATMULLROM:
+            return { 2.0, catmullRomWeight };
+        case KERNEL_LANCZOS3:
+            return { 3.0, lanczos3Weight };
+        default:
+            return { 1.0, bilinearWeight };
+    }
+}
+
+// Each output pixel reads exactly `taps` source pixels starting at bounds[i].
+// The window is shifted to stay inside the source, unused taps have zero weight.
+struct WeightTable {
+    int taps = 0;
+    std::vector<int> bounds;
+    std::vector<int16_t> weights;
+};
+
+WeightTable buildWeights(int srcSize, int dstSize, const Kernel &kernel) {
+    WeightTable t;
+    t.bounds.resize(dstSize);
+    if(srcSize == dstSize) {
+        t.taps = 1;
+        t.weights.assign(dstSize, 1 << PRECISION_BITS);
+        for(int i = 0; i < dstSize; i++)
+            t.bounds[i] = i;
+        return t;
+    }
+    double scale = static_cast<double>(srcSize) / dstSize;
+    // widen the kernel when downscaling so every source pixel contributes
+    double filterScale = std::max(scale, 1.0);
+    double support = kernel.support * filterScale;
+    t.taps = std::min(static_cast<int>(std::ceil(support)) * 2 + 1, srcSize);
+    t.weights.assign(static_cast<size_t>(dstSize) * t.taps, 0);
+    std::vector<double> w(t.taps);
+    for(int i = 0; i < dstSize; i++) {
+        double center = (i + 0.5) * scale;
+        int xmin = std::max(static_cast<int>(std::floor(center - support + 0.5)), 0);
+        int xmax = std::min(static_cast<int>(std::floor(center + support + 0.5)), srcSize);
+        xmin = std::min(xmin, srcSize - 1);
+        xmax = std::clamp(xmax, xmin + 1, xmin + t.taps);
+        int count = xmax - xmin;
+        double sum = 0.0;
+        for(int j = 0; j < count; j++) {
+            w[j] = kernel.weight((j + xmin - center + 0.5) / filterScale);
+            sum += w[j];
+        }
+        int first = std::min(xmin, srcSize - t.taps);
+        int16_t *dst = &t.weights[static_cast<size_t>(i) * t.taps + (xmin - first)];
+        int total = 0, peak = 0;
+        for(int j = 0; j < count; j++) {
+            dst[j] = static_cast<int16_t>(std::lround((sum != 0.0 ? w[j] / sum : 1.0 / count) * (1 << PRECISION_BITS)));
+            total += dst[j];
+            if(dst[j] > dst[peak])
+                peak = j;
+        }
+        // put the rounding error on the largest weight so flat areas stay flat
+        dst[peak] = static_cast<int16_t>(dst[peak] + (1 << PRECISION_BITS) - total);
+        t.bounds[i] = first;
+    }
+    return t;
+}
+
+inline uchar clamp8(int value) {
+    return static_cast<uchar>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// one row, 4 channels per pixel
+void horizontalRow(const uchar *src, uchar *dst, int width, const WeightTable &t) {
+    for(int x = 0; x < width; x++) {
+        const uchar *s = src + t.bounds[x] * 4;
+        const int16_t *w = &t.weights[static_cast<size_t>(x) * t.taps];
+#if defined(RESAMPLER_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        __m128i acc = _mm_set1_epi32(ROUNDING);
+        int k = 0;
+        for(; k + 1 < t.taps; k += 2) {
+            // interleave two neighbouring pixels channel-wise so a single madd applies both weights
+            __m128i px = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(s + k * 4));
+            px = _mm_unpacklo_epi8(_mm_unpacklo_epi8(px, _mm_srli_si128(px, 4)), zero);
+            __m128i wv = _mm_unpacklo_epi16(_mm_set1_epi16(w[k]), _mm_set1_epi16(w[k + 1]));
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, wv));
+        }
+        if(k < t.taps) {
+            int32_t p;
+            memcpy(&p, s + k * 4, 4);
+            __m128i px = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p), zero), zero);
+            acc = _mm_add_epi32(acc, _mm_madd_epi16(px, _mm_set1_epi16(w[k])));
+        }
+        acc = _mm_srai_epi32(acc, PRECISION_BITS);
+        acc = _mm_packs_epi32(acc, acc);
+        int32_t out = _mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+        memcpy(dst + x * 4, &out, 4);
+#elif defined(RESAMPLER_NEON)
+        int32x4_t acc = vdupq_n_s32(ROUNDING);
+        for(int k = 0; k < t.taps; k++) {
+            uint32_t p;
+            memcpy(&p, s + k * 4, 4);
+            int16x8_t px = vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(p))));
+            acc = vmlal_n_s16(acc, vget_low_s16(px), w[k]);
+        }
+        int16x4_t narrow = vqshrn_n_s32(acc, PRECISION_BITS);
+        uint32_t out = vget_lane_u32(vreinterpret_u32_u8(vqmovun_s16(vcombine_s16(narrow, narrow))), 0);
+        memcpy(dst + x * 4, &out, 4);
+#else
+        int acc[4] = { ROUNDING, ROUNDING, ROUNDING, ROUNDING };
+        for(int k = 0; k < t.taps; k++)
+            for(int c = 0; c < 4; c++)
+                acc[c] += s[k * 4 + c] * w[k];
+        for(int c = 0; c < 4; c++)
+            dst[x * 4 + c] = clamp8(acc[c] >> PRECISION_BITS);
+#endif
+    }
+}
+
+// Vertical pass helpers process whole blocks of pixels and return how many were done.
+// Whatever is left at the end of the row goes through the scalar loop.
+#ifdef RESAMPLER_AVX2
+__attribute__((target("avx2")))
+int verticalAvx2(const uchar *src, ptrdiff_t stride, const int16_t *w, int taps, uchar *dst, int width) {
+    const __m256i zero = _mm256_setzero_si256();
+    int x = 0;
+    for(; x + 8 <= width; x += 8) {
+        const uchar *s = src + x * 4;
+        __m256i s0 = _mm256_set1_epi32(ROUNDING), s1 = s0, s2 = s0, s3 = s0;
+        int k = 0;
+        for(; k + 1 < taps; k += 2) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + k * stride));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + (k + 1) * stride));
+            __m256i wv = _mm256_unpacklo_epi16(_mm256_set1_epi16(w[k]), _mm256_set1_epi16(w[k + 1]));
+            __m256i lo = _mm256_unpacklo_epi8(a, b);
+            __m256i hi = _mm256_unpackhi_epi8(a, b);
+            s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_unpacklo_epi8(lo, zero), wv));
+            s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(_mm256_unpackhi_epi8(lo, zero), wv));
+            s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(_mm256_unpacklo_epi8(hi, zero), wv));
+            s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(_mm256_unpackhi_epi8(hi, zero), wv));
+        }
+        if(k < taps) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + k * stride));
+            __m256i wv = _mm256_set1_epi16(w[k]);
+            __m256i lo = _mm256_unpacklo_epi8(a, zero);
+            __m256i hi = _mm256_unpackhi_epi8(a, zero);
+            s0 = _mm256_add_epi32(s0, _mm256_madd_epi16(_mm256_unpacklo_epi16(lo, zero), wv));
+            s1 = _mm256_add_epi32(s1, _mm256_madd_epi16(_mm256_unpackhi_epi16(lo, zero), wv));
+            s2 = _mm256_add_epi32(s2, _mm256_madd_epi16(_mm256_unpacklo_epi16(hi, zero), wv));
+            s3 = _mm256_add_epi32(s3, _mm256_madd_epi16(_mm256_unpackhi_epi16(hi, zero), wv));
+        }
+        s0 = _mm256_srai_epi32(s0, PRECISION_BITS);
+        s1 = _mm256_srai_epi32(s1, PRECISION_BITS);
+        s2 = _mm256_srai_epi32(s2, PRECISION_BITS);
+        s3 = _mm256_srai_epi32(s3, PRECISION_BITS);
+        // unpack and pack both work within 128-bit lanes, so the pixel order comes out right
+        __m256i out = _mm256_packus_epi16(_mm256_packs_epi32(s0, s1), _mm256_packs_epi32(s2, s3));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + x * 4), out);
+    }
+    return x;
+}
+
+bool cpuHasAvx2() {
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+}
+#endif
+
+#if defined(RESAMPLER_SSE2)
+int verticalSimd(const uchar *src, ptrdiff_t stride, const int16_t *w, int taps, uchar *dst, int width) {
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for(; x + 4 <= width; x += 4) {
+        const uchar *s = src + x * 4;
+        __m128i s0 = _mm_set1_epi32(ROUNDING), s1 = s0, s2 = s0, s3 = s0;
+        int k = 0;
+        for(; k + 1 < taps; k += 2) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + k * stride));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + (k + 1) * stride));
+            __m128i wv = _mm_unpacklo_epi16(_mm_set1_epi16(w[k]), _mm_set1_epi16(w[k + 1]));
+            __m128i lo = _mm_unpacklo_epi8(a, b);
+            __m128i hi = _mm_unpackhi_epi8(a, b);
+            s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), wv));
+            s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), wv));
+            s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), wv));
+            s3 = _mm_add_epi32(s3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), wv));
+        }
+        if(k < taps) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + k * stride));
+            __m128i wv = _mm_set1_epi16(w[k]);
+            __m128i lo = _mm_unpacklo_epi8(a, zero);
+            __m128i hi = _mm_unpackhi_epi8(a, zero);
+            s0 = _mm_add_epi32(s0, _mm_madd_epi16(_mm_unpacklo_epi16(lo, zero), wv));
+            s1 = _mm_add_epi32(s1, _mm_madd_epi16(_mm_unpackhi_epi16(lo, zero), wv));
+            s2 = _mm_add_epi32(s2, _mm_madd_epi16(_mm_unpacklo_epi16(hi, zero), wv));
+            s3 = _mm_add_epi32(s3, _mm_madd_epi16(_mm_unpackhi_epi16(hi, zero), wv));
+        }
+        s0 = _mm_srai_epi32(s0, PRECISION_BITS);
+        s1 = _mm_srai_epi32(s1, PRECISION_BITS);
+        s2 = _mm_srai_epi32(s2, PRECISION_BITS);
+        s3 = _mm_srai_epi32(s3, PRECISION_BITS);
+        __m128i out = _mm_packus_epi16(_mm_packs_epi32(s0, s1), _mm_packs_epi32(s2, s3));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + x * 4), out);
+    }
+    return x;
+}
+#elif defined(RESAMPLER_NEON)
+int verticalSimd(const uchar *src, ptrdiff_t stride, const int16_t *w, int taps, uchar *dst, int width) {
+    int x = 0;
+    for(; x + 4 <= width; x += 4) {
+        const uchar *s = src + x * 4;
+        int32x4_t s0 = vdupq_n_s32(ROUNDING), s1 = s0, s2 = s0, s3 = s0;
+        for(int k = 0; k < taps; k++) {
+            uint8x16_t a = vld1q_u8(s + k * stride);
+            int16x8_t lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(a)));
+            int16x8_t hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(a)));
+            s0 = vmlal_n_s16(s0, vget_low_s16(lo), w[k]);
+            s1 = vmlal_n_s16(s1, vget_high_s16(lo), w[k]);
+            s2 = vmlal_n_s16(s2, vget_low_s16(hi), w[k]);
+            s3 = vmlal_n_s16(s3, vget_high_s16(hi), w[k]);
+        }
+        int16x8_t lo = vcombine_s16(vqshrn_n_s32(s0, PRECISION_BITS), vqshrn_n_s32(s1, PRECISION_BITS));
+        int16x8_t hi = vcombine_s16(vqshrn_n_s32(s2, PRECISION_BITS), vqshrn_n_s32(s3, PRECISION_BITS));
+        vst1q_u8(dst + x * 4, vcombine_u8(vqmovun_s16(lo), vqmovun_s16(hi)));
+    }
+    return x;
+}
+#endif
+
+// src points to the first of `taps` consecutive rows
+void verticalRow(const uchar *src, ptrdiff_t stride, const int16_t *w, int taps, uchar *dst, int width) {
+    int x = 0;
+#ifdef RESAMPLER_AVX2
+    if(cpuHasAvx2())
+        x = verticalAvx2(src, stride, w, taps, dst, width);
+#endif
+#if defined(RESAMPLER_SSE2) || defined(RESAMPLER_NEON)
+    x += verticalSimd(src + x * 4, stride, w, taps, dst + x * 4, width - x);
+#endif
+    for(int i = x * 4; i < width * 4; i++) {
+        int acc = ROUNDING;
+        for(int k = 0; k < taps; k++)
+            acc += src[k * stride + i] * w[k];
+        dst[i] = clamp8(acc >> PRECISION_BITS);
+    }
+}
+
+// negative kernel lobes can push color above alpha, which is invalid for premultiplied data
+void clampPremultiplied(uchar *row, int width) {
+    QRgb *px = reinterpret_cast<QRgb *>(row);
+    for(int x = 0; x < width; x++) {
+        int a = qAlpha(px[x]);
+        if(a == 255)
+            continue;
+        px[x] = qRgba(std::min(qRed(px[x]), a), std::min(qGreen(px[x]), a), std::min(qBlue(px[x]), a), a);
+    }
+}
+
+struct ResampleJob {
+    const uchar *src;
+    ptrdiff_t srcStride;
+    uchar *dst;
+    ptrdiff_t dstStride;
+    int dstWidth, dstHeight;
+    bool premultiplied;
+    WeightTable horizontal, vertical;
+    int bandRows, bandCount;
+    std::atomic_int nextBand;
+    const std::atomic_bool *cancelled;
+};
+
+// Threads grab bands until none are left.
+// Each band resamples only the source rows it needs horizontally, then runs the vertical pass.
+void processBands(ResampleJob &job) {
+    const ptrdiff_t tmpStride = static_cast<ptrdiff_t>(job.dstWidth) * 4;
+    std::vector<uchar> tmp;
+    int band;
+    while((band = job.nextBand.fetch_add(1)) < job.bandCount) {
+        if(job.cancelled && *job.cancelled)
+            return;
+        int y0 = band * job.bandRows;
+        int y1 = std::min(y0 + job.bandRows, job.dstHeight);
+        int first = job.vertical.bounds[y0];
+        int last = job.vertical.bounds[y1 - 1] + job.vertical.taps;
+        tmp.resize(static_cast<size_t>(last - first) * tmpStride);
+        for(int y = first; y < last; y++)
+            horizontalRow(job.src + y * job.srcStride, tmp.data() + (y - first) * tmpStride, job.dstWidth, job.horizontal);
+        for(int y = y0; y < y1; y++) {
+            uchar *out = job.dst + y * job.dstStride;
+            verticalRow(tmp.data() + (job.vertical.bounds[y] - first) * tmpStride, tmpStride,
+                        &job.vertical.weights[static_cast<size_t>(y) * job.vertical.taps], job.vertical.taps,
+                        out, job.dstWidth);
+            if(job.premultiplied)
+                clampPremultiplied(out, job.dstWidth);
+        }
+    }
+}
+
+class ResampleTask : public QRunnable {
+public:
+    ResampleTask(ResampleJob &job, QSemaphore &done) : job(job), done(done) {}
+    void run() override {
+        processBands(job);
+        done.release();
+    }
+private:
+    ResampleJob &job;
+    QSemaphore &done;
+};
+
+QThreadPool *resamplerPool() {
+    static QThreadPool pool;
+    static bool init = [] {
+        pool.setMaxThreadCount(std::max(QThread::idealThreadCount() - 1, 1));
+        return true;
+    }();
+    Q_UNUSED(init)
+    return &pool;
+}
+
+} // namespace
+
+QImage Resampler::resample(const QImage &src, QSize destSize, ResampleKernel kernel,
+                           const std::atomic_bool *cancelled) {
+    if(src.isNull() || destSize.isEmpty())
+        return QImage();
+    QImage::Format format = src.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32;
+    QImage source = (src.format() == format) ? src : src.convertToFormat(format);
+    QImage dest(destSize, format);
+    if(source.isNull() || dest.isNull())
+        return QImage();
+
+    Kernel k = kernelFor(kernel);
+    ResampleJob job;
+    job.src = source.constBits();
+    job.srcStride = source.bytesPerLine();
+    job.dst = dest.bits();
+    job.dstStride = dest.bytesPerLine();
+    job.dstWidth = dest.width();
+    job.dstHeight = dest.height();
+    job.premultiplied = (format == QImage::Format_ARGB32_Premultiplied);
+    job.horizontal = buildWeights(source.width(), dest.width(), k);
+    job.vertical = buildWeights(source.height(), dest.height(), k);
+    job.bandRows = std::max(BAND_SOURCE_ROWS, BAND_SOURCE_ROWS * dest.height() / source.height());
+    job.bandCount = (dest.height() + job.bandRows - 1) / job.bandRows;
+    job.nextBand = 0;
+    job.cancelled = cancelled;
+
+    // helpers only join if a pool thread is free right now; this thread always works too
+    QSemaphore done;
+    int helpers = 0;
+    if(static_cast<qint64>(dest.width()) * dest.height() >= PARALLEL_MIN_PIXELS) {
+        int wanted = std::min(resamplerPool()->maxThreadCount(), job.bandCount - 1);
+        for(; helpers < wanted; helpers++) {
+            auto task = new ResampleTask(job, done);
+            if(!resamplerPool()->tryStart(task)) {
+                delete task;
+                break;
+            }
+        }
+    }
+    processBands(job);
+    done.acquire(helpers);
+    if(cancelled && *cancelled)
+        return QImage();
+    return dest;
+}
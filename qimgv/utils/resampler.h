@@ -0,0 +1,23 @@
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <atomic>
+
+// Separable fixed-point resampler.
+// Weights are precomputed per output row/column; inner loops use sse2/avx2/neon when available.
+// Large images are split into horizontal bands which are processed in parallel.
+
+enum ResampleKernel {
+    KERNEL_BILINEAR,
+    KERNEL_BICUBIC,
+    KERNEL_CATMULLROM,
+    KERNEL_LANCZOS3
+};
+
+class Resampler {
+public:
+    // returns a null image if `cancelled` gets set while working
+    static QImage resample(const QImage &src, QSize destSize, ResampleKernel kernel,
+                           const std::atomic_bool *cancelled = nullptr);
+};
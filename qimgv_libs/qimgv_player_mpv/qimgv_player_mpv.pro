@@ -36,12 +36,15 @@ windows {
 SOURCES += \
         src/mpvwidget.cpp \
         src/videoplayer.cpp \
-        src/videoplayermpv.cpp
+        src/videoplayermpv.cpp \
+        src/framegrabbermpv.cpp
 
 HEADERS += \
         src/mpvwidget.h \
         src/videoplayer.h \
-        src/videoplayermpv.h
+        src/videoplayermpv.h \
+        src/framegrabber.h \
+        src/framegrabbermpv.h
 
 unix {
     target.path = /usr/lib
@@ -0,0 +1,160 @@
+#include "framegrabbermpv.h"
+#include <QElapsedTimer>
+#include <QDebug>
+
+// how long a single file may take
+static const qint64 GRAB_TIMEOUT_MS = 3000;
+
+FrameGrabberMpv::FrameGrabberMpv()
+    : mpv(nullptr),
+      renderContext(nullptr)
+{
+#ifdef FRAMEGRABBER_MPV_SW_RENDER
+    mpv = mpv_create();
+    if(!mpv)
+        return;
+    mpv_set_option_string(mpv, "config", "no");
+    mpv_set_option_string(mpv, "load-scripts", "no");
+    mpv_set_option_string(mpv, "terminal", "no");
+    mpv_set_option_string(mpv, "ytdl", "no");
+    mpv_set_option_string(mpv, "idle", "yes");
+    mpv_set_option_string(mpv, "pause", "yes");
+    mpv_set_option_string(mpv, "ao", "null");
+    mpv_set_option_string(mpv, "aid", "no");
+    mpv_set_option_string(mpv, "sid", "no");
+    mpv_set_option_string(mpv, "hwdec", "no");
+    mpv_set_option_string(mpv, "vo", "libmpv");
+    if(mpv_initialize(mpv) < 0) {
+        mpv_terminate_destroy(mpv);
+        mpv = nullptr;
+        return;
+    }
+    mpv_render_param params[] = {
+        { MPV_RENDER_PARAM_API_TYPE, const_cast<char*>(MPV_RENDER_API_TYPE_SW) },
+        { MPV_RENDER_PARAM_INVALID, nullptr }
+    };
+    if(mpv_render_context_create(&renderContext, mpv, params) < 0) {
+        renderContext = nullptr;
+        mpv_terminate_destroy(mpv);
+        mpv = nullptr;
+    }
+#endif
+}
+
+FrameGrabberMpv::~FrameGrabberMpv() {
+#ifdef FRAMEGRABBER_MPV_SW_RENDER
+    // render context must go first
+    if(renderContext)
+        mpv_render_context_free(renderContext);
+    if(mpv)
+        mpv_terminate_destroy(mpv);
+#endif
+}
+
+bool FrameGrabberMpv::isValid() const {
+    return mpv && renderContext;
+}
+
+bool FrameGrabberMpv::grab(const QString &path, double position, int shortSide, QImage &frame, QSize &videoSize) {
+#ifdef FRAMEGRABBER_MPV_SW_RENDER
+    if(!isValid())
+        return false;
+    QElapsedTimer timer;
+    timer.start();
+    // applies to the next loaded file; seeking happens while paused so we get exactly one frame
+    QByteArray start = QByteArray::number(qBound(0.0, position, 1.0) * 100.0, 'g', 4) + "%";
+    mpv_set_property_string(mpv, "start", start.constData());
+    QByteArray pathUtf8 = path.toUtf8();
+    const char *cmd[] = { "loadfile", pathUtf8.constData(), nullptr };
+    if(mpv_command(mpv, cmd) < 0)
+        return false;
+    bool ok = waitForFrame(GRAB_TIMEOUT_MS);
+    int64_t w = 0, h = 0;
+    if(ok) {
+        mpv_get_property(mpv, "dwidth", MPV_FORMAT_INT64, &w);
+        mpv_get_property(mpv, "dheight", MPV_FORMAT_INT64, &h);
+        ok = (w > 0 && h > 0);
+    }
+    if(ok) {
+        videoSize = QSize(static_cast<int>(w), static_cast<int>(h));
+        QSize scaledSize = videoSize;
+        if(shortSide > 0 && qMin(w, h) > shortSide)
+            scaledSize = videoSize.scaled(shortSide, shortSide, Qt::KeepAspectRatioByExpanding);
+        frame = QImage(scaledSize, QImage::Format_RGBX8888);
+        int size[2] = { scaledSize.width(), scaledSize.height() };
+        size_t stride = static_cast<size_t>(frame.bytesPerLine());
+        mpv_render_param params[] = {
+            { MPV_RENDER_PARAM_SW_SIZE, size },
+            { MPV_RENDER_PARAM_SW_FORMAT, const_cast<char*>("rgb0") },
+            { MPV_RENDER_PARAM_SW_STRIDE, &stride },
+            { MPV_RENDER_PARAM_SW_POINTER, frame.bits() },
+            { MPV_RENDER_PARAM_INVALID, nullptr }
+        };
+        ok = (mpv_render_context_render(renderContext, params) >= 0);
+    }
+    if(!ok)
+        qDebug() << "[FrameGrabberMpv] could not grab a frame from" << path << "in" << timer.elapsed() << "ms";
+    unload();
+    return ok;
+#else
+    Q_UNUSED(path)
+    Q_UNUSED(position)
+    Q_UNUSED(shortSide)
+    Q_UNUSED(frame)
+    Q_UNUSED(videoSize)
+    return false;
+#endif
+}
+
+// Waits until the seek is done and a frame is ready for rendering.
+bool FrameGrabberMpv::waitForFrame(qint64 timeout) {
+#ifdef FRAMEGRABBER_MPV_SW_RENDER
+    QElapsedTimer timer;
+    timer.start();
+    bool restarted = false;
+    while(timer.elapsed() < timeout) {
+        if(restarted && (mpv_render_context_update(renderContext) & MPV_RENDER_UPDATE_FRAME))
+            return true;
+        // short waits so we notice new frames, the render update callback can't wake us up
+        mpv_event *event = mpv_wait_event(mpv, restarted ? 0.01 : 0.1);
+        switch(event->event_id) {
+        case MPV_EVENT_PLAYBACK_RESTART:
+            restarted = true;
+            break;
+        case MPV_EVENT_END_FILE:
+            return false;
+        default:
+            break;
+        }
+    }
+#else
+    Q_UNUSED(timeout)
+#endif
+    return false;
+}
+
+void FrameGrabberMpv::unload() {
+#ifdef FRAMEGRABBER_MPV_SW_RENDER
+    const char *cmd[] = { "stop", nullptr };
+    mpv_command(mpv, cmd);
+    // drain events of the previous file so they don't confuse the next grab
+    QElapsedTimer timer;
+    timer.start();
+    while(timer.elapsed() < GRAB_TIMEOUT_MS) {
+        mpv_event *event = mpv_wait_event(mpv, 0.1);
+        if(event->event_id == MPV_EVENT_END_FILE ||
+           event->event_id == MPV_EVENT_IDLE ||
+           event->event_id == MPV_EVENT_NONE)
+            break;
+    }
+#endif
+}
+
+FrameGrabber *CreateFrameGrabber() {
+    FrameGrabberMpv *grabber = new FrameGrabberMpv();
+    if(!grabber->isValid()) {
+        delete grabber;
+        return nullptr;
+    }
+    return grabber;
+}
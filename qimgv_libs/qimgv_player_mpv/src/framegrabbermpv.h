@@ -0,0 +1,38 @@
+#pragma once
+
+#include "framegrabber.h"
+#include <mpv/client.h>
+
+#if defined QIMGV_PLAYER_MPV_LIBRARY
+ #define TEST_COMMON_DLLSPEC Q_DECL_EXPORT
+#else
+ #define TEST_COMMON_DLLSPEC Q_DECL_IMPORT
+#endif
+
+// the software render api appeared in libmpv 1.105
+#if MPV_CLIENT_API_VERSION >= MPV_MAKE_VERSION(1, 105)
+ #define FRAMEGRABBER_MPV_SW_RENDER
+ #include <mpv/render.h>
+#endif
+
+struct mpv_render_context;
+
+// Headless mpv instance which renders frames into memory with the software renderer.
+// The handle stays alive between files, so only the first grab pays for startup.
+class FrameGrabberMpv : public FrameGrabber {
+public:
+    FrameGrabberMpv();
+    ~FrameGrabberMpv();
+    bool isValid() const;
+    bool grab(const QString &path, double position, int shortSide, QImage &frame, QSize &videoSize);
+
+private:
+    mpv_handle *mpv;
+    mpv_render_context *renderContext;
+
+    bool waitForFrame(qint64 timeout);
+    void unload();
+};
+
+// returns nullptr if libmpv can't render without a window
+extern "C" TEST_COMMON_DLLSPEC FrameGrabber *CreateFrameGrabber();